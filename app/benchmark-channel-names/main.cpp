@@ -0,0 +1,228 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "EXRChannelName.h"
+#include "Util.h"
+
+using namespace SEXR;
+
+const size_t N_BANDS = 100;
+const size_t N_RUNS  = 5;
+
+
+// The regular expression parser the library used before, kept as the
+// reference for the timings. The results are checked by the
+// channel-names test
+SpectrumType regexChannelType(
+  const std::string &channelName,
+  int &              polarisationComponent,
+  double &           wavelength_nm,
+  double &           reradiation_wavelength_nm)
+{
+    const std::string exprRefl   = "T";
+    const std::string exprStokes = "S([0-3])";
+    const std::string exprPola   = "((" + exprStokes + ")|" + exprRefl + ")";
+    const std::string exprValue  = "(\\d*,?\\d*([Ee][+-]?\\d+)?)";
+    const std::string exprUnits = "(Y|Z|E|P|T|G|M|k|h|da|d|c|m|u|n|p)?(m|Hz)";
+
+    const std::regex exprDiagonal(
+      "^" + exprPola + "\\." + exprValue + exprUnits + "$");
+    const std::regex exprRerad(
+      "^" + exprRefl + "\\." + exprValue + exprUnits + "\\." + exprValue
+      + exprUnits + "$");
+
+    std::smatch matches;
+
+    if (std::regex_search(channelName, matches, exprDiagonal)) {
+        SpectrumType type = SpectrumType::REFLECTIVE;
+
+        if (matches[1].str()[0] == 'S') {
+            type                  = SpectrumType::EMISSIVE;
+            polarisationComponent = std::stoi(matches[3].str());
+            if (polarisationComponent > 0) {
+                type = type | SpectrumType::POLARISED;
+            }
+        }
+
+        std::string valueStr(matches[4].str());
+        std::replace(valueStr.begin(), valueStr.end(), ',', '.');
+
+        wavelength_nm = Util::strToNanometers(
+          std::stod(valueStr),
+          matches[6].str(),
+          matches[7].str());
+
+        return type;
+    }
+
+    if (std::regex_search(channelName, matches, exprRerad)) {
+        std::string valueStrI(matches[1].str());
+        std::replace(valueStrI.begin(), valueStrI.end(), ',', '.');
+
+        wavelength_nm = Util::strToNanometers(
+          std::stof(valueStrI),
+          matches[3].str(),
+          matches[4].str());
+
+        std::string valueStrO(matches[5].str());
+        std::replace(valueStrO.begin(), valueStrO.end(), ',', '.');
+
+        reradiation_wavelength_nm = Util::strToNanometers(
+          std::stof(valueStrO),
+          matches[7].str(),
+          matches[8].str());
+
+        return SpectrumType::BISPECTRAL;
+    }
+
+    return SpectrumType::UNDEFINED;
+}
+
+
+struct Parsed
+{
+    SpectrumType type;
+    int          polarisationComponent;
+    double       wavelength_nm;
+    double       reradiation_wavelength_nm;
+};
+
+
+template<typename Parser>
+double benchmark(
+  Parser parser, const std::vector<std::string> &names, std::vector<Parsed> &out)
+{
+    double best = 1e30;
+
+    for (size_t run = 0; run < N_RUNS; run++) {
+        std::memset(out.data(), 0, out.size() * sizeof(Parsed));
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < names.size(); i++) {
+            out[i].type = parser(
+              names[i],
+              out[i].polarisationComponent,
+              out[i].wavelength_nm,
+              out[i].reradiation_wavelength_nm);
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+
+    return best;
+}
+
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    // Header of a polarised bispectral image with 100 bands
+    std::vector<double> wavelengths_nm;
+
+    for (size_t i = 0; i < N_BANDS; i++) {
+        wavelengths_nm.push_back(380. + 4.25 * i);
+    }
+
+    std::vector<std::string> names = {"R", "G", "B", "A"};
+
+    for (size_t i = 0; i < N_BANDS; i++) {
+        for (int s = 0; s < 4; s++) {
+            names.push_back(EXRChannelName::emissive(s, wavelengths_nm[i]));
+        }
+
+        names.push_back(EXRChannelName::reflective(wavelengths_nm[i]));
+
+        for (size_t o = i + 1; o < N_BANDS; o++) {
+            names.push_back(EXRChannelName::reradiation(
+              wavelengths_nm[i],
+              wavelengths_nm[o]));
+        }
+    }
+
+    const size_t nHeaderChannels = names.size();
+
+    // Other spellings allowed by the format, and non spectral names
+    const std::vector<std::string> variants
+      = {"S0.500nm",       "S3.0,5um",     "T.5E2nm",    "T.5e+2nm",
+         "S1.599584916GHz", "T.600THz",    "T.5Em",      "T.500dam",
+         "T.,5um",          "T.500nm.6E2nm", "S0.500nm.600nm", "S4.500nm",
+         "T.500",           "T.500nm.",    "T.500xm",    "S0.500,nm",
+         "Tx.500nm",        "T.500nm.600Hz", "T.500mm",  "S2.12,5e-1km"};
+
+    names.insert(names.end(), variants.begin(), variants.end());
+
+    std::vector<Parsed> parsedRegex(names.size());
+    std::vector<Parsed> parsedCodec(names.size());
+
+    const double tRegex
+      = benchmark(regexChannelType, names, parsedRegex);
+    const double tCodec
+      = benchmark(EXRChannelName::parse, names, parsedCodec);
+
+    std::cout << "Channel names: " << names.size() << " (" << nHeaderChannels
+              << " in the header of a " << N_BANDS
+              << " bands polarised bispectral image)" << std::endl
+              << std::endl;
+
+    std::cout << std::setw(10) << "parser" << std::setw(14) << "total ms"
+              << std::setw(14) << "ns / channel" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    std::cout << std::setw(10) << "regex" << std::setw(14) << tRegex * 1e3
+              << std::setw(14) << tRegex / names.size() * 1e9 << std::endl;
+    std::cout << std::setw(10) << "codec" << std::setw(14) << tCodec * 1e3
+              << std::setw(14) << tCodec / names.size() * 1e9 << std::endl
+              << std::endl;
+
+    std::cout << "Speedup: " << tRegex / tCodec << "x" << std::endl;
+
+    return 0;
+}
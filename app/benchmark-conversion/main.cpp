@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "SpectrumConverterKernels.h"
+
+using namespace SEXR;
+
+// Number of floats of pixel data: small enough to stay in the L2
+// cache so the timings reflect the kernels, not the memory bandwidth
+const size_t DATA_BUDGET = 1 << 16;
+const size_t N_REPEATS   = 200;
+const size_t N_RUNS      = 5;
+
+
+// Best time in seconds of N_RUNS runs, for one conversion
+double benchmark(
+  BatchKernel                   kernel,
+  const std::vector<BatchTerm> &terms,
+  size_t                        nPixels,
+  std::vector<float> &          rgb)
+{
+    double best = 1e30;
+
+    for (size_t run = 0; run < N_RUNS; run++) {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t r = 0; r < N_REPEATS; r++) {
+            kernel(terms.data(), terms.size(), nPixels, 1.F, true, rgb.data());
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+
+        best = std::min(
+          best,
+          std::chrono::duration<double>(end - start).count() / N_REPEATS);
+    }
+
+    return best;
+}
+
+
+void compare(const char *name, size_t nBands, const std::vector<size_t> &sizes)
+{
+    std::mt19937                          gen(0);
+    std::uniform_real_distribution<float> dis(0.F, 1.F);
+
+    size_t pixelSize = 0;
+
+    for (size_t s : sizes) {
+        pixelSize += s;
+    }
+
+    const size_t nPixels = DATA_BUDGET / pixelSize;
+
+    std::vector<std::vector<float>> data(sizes.size());
+    std::vector<std::vector<float>> weights(sizes.size());
+    std::vector<BatchTerm>          terms(sizes.size());
+
+    for (size_t t = 0; t < sizes.size(); t++) {
+        data[t].resize(nPixels * sizes[t]);
+        weights[t].resize(3 * SpectrumConverterKernels::paddedSize(sizes[t]));
+
+        for (float &v : data[t]) v = dis(gen);
+        for (float &v : weights[t]) v = dis(gen);
+
+        terms[t] = {data[t].data(), sizes[t], weights[t].data()};
+    }
+
+    std::vector<float> rgbGeneric(3 * nPixels);
+    std::vector<float> rgbFixed(3 * nPixels);
+
+    const double tGeneric = benchmark(
+      SpectrumConverterKernels::kernel(),
+      terms,
+      nPixels,
+      rgbGeneric);
+    const double tFixed = benchmark(
+      SpectrumConverterKernels::kernel(nBands),
+      terms,
+      nPixels,
+      rgbFixed);
+
+    float maxError = 0.F;
+
+    for (size_t i = 0; i < rgbGeneric.size(); i++) {
+        maxError = std::max(
+          maxError,
+          std::abs(rgbGeneric[i] - rgbFixed[i]) / std::max(rgbGeneric[i], 1.F));
+    }
+
+    std::cout << std::setw(12) << name << std::setw(8) << nBands
+              << std::setw(14) << nPixels / tGeneric * 1e-6 << std::setw(14)
+              << nPixels / tFixed * 1e-6 << std::setw(10)
+              << tGeneric / tFixed << "x" << std::setw(14) << maxError
+              << std::endl;
+}
+
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    std::cout << "Kernel instruction set: "
+              << SpectrumConverterKernels::kernelName() << std::endl
+              << std::endl;
+
+    std::cout << std::setw(12) << "type" << std::setw(8) << "bands"
+              << std::setw(14) << "generic Mpx/s" << std::setw(14)
+              << "fixed Mpx/s" << std::setw(11) << "speedup" << std::setw(14)
+              << "max rel. err" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(2);
+
+    const size_t bandCounts[] = {31, 36, 41};
+
+    for (size_t n : bandCounts) {
+        const size_t r = n * (n - 1) / 2;
+
+        compare("reflective", n, {n});
+        compare("refl + emis", n, {n, n});
+        compare("bispectral", n, {n, r});
+        compare("bisp + emis", n, {n, r, n});
+    }
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <EXRBiSpectralImage.h>
+#include <Threading.h>
+
+using namespace SEXR;
+
+const size_t N_RUNS = 3;
+
+
+// Best time in seconds of N_RUNS runs of a function
+template<typename F>
+double benchmark(F f)
+{
+    double best = 1e30;
+
+    for (size_t run = 0; run < N_RUNS; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto end = std::chrono::steady_clock::now();
+
+        best = std::min(
+          best,
+          std::chrono::duration<double>(end - start).count());
+    }
+
+    return best;
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && argc != 4) {
+        std::cerr << "Usage:" << std::endl
+                  << "------" << std::endl
+                  << argv[0] << " [<width> <height> <n_bands>]" << std::endl
+                  << std::endl
+                  << "Saves and loads a ZIP compressed bispectral file "
+                     "with 1 to N threads."
+                  << std::endl;
+        return 0;
+    }
+
+    const size_t width  = argc > 1 ? std::stoul(argv[1]) : 256;
+    const size_t height = argc > 1 ? std::stoul(argv[2]) : 256;
+    const size_t nBands = argc > 1 ? std::stoul(argv[3]) : 31;
+
+    const std::string filename = "benchmark-io.exr";
+
+    // Whole wavelengths, so they are written exactly in channel names
+    const size_t step_nm = std::max(size_t(300) / nBands, size_t(1));
+
+    std::vector<float> wavelengths_nm(nBands);
+
+    for (size_t i = 0; i < nBands; i++) {
+        wavelengths_nm[i] = float(400 + i * step_nm);
+    }
+
+    // Smooth values with some noise, so the compression has work to do
+    EXRBiSpectralImage image(
+      width,
+      height,
+      wavelengths_nm,
+      SpectrumType::EMISSIVE | SpectrumType::BISPECTRAL);
+
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            for (size_t i = 0; i < nBands; i++) {
+                const float noise = float((x * 7919 + y * 104729 + i) % 97);
+
+                image.emissive(x, y, i, 0)
+                  = 1.F + std::sin(0.01F * float(x + i)) + 1e-3F * noise;
+
+                for (size_t o = i; o < nBands; o++) {
+                    image.reflective(x, y, i, o)
+                      = 0.5F + 0.25F * std::cos(0.02F * float(y + o))
+                        + 1e-4F * noise;
+                }
+            }
+        }
+    }
+
+    const size_t nChannels = nBands + nBands * (nBands + 1) / 2;
+
+    std::cout << width << "x" << height << " pixels, " << nChannels
+              << " channels, ZIP compression" << std::endl
+              << std::endl;
+
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "save (s)"
+              << std::setw(10) << "speedup" << std::setw(12) << "load (s)"
+              << std::setw(10) << "speedup" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    // Powers of two up to the number of hardware threads
+    const size_t nHardware = std::max(std::thread::hardware_concurrency(), 1U);
+
+    std::vector<size_t> threadCounts;
+
+    for (size_t n = 1; n < nHardware; n *= 2) {
+        threadCounts.push_back(n);
+    }
+
+    threadCounts.push_back(nHardware);
+
+    double tSave1 = 0, tLoad1 = 0;
+
+    for (size_t n : threadCounts) {
+        Threading::setThreadCount(n);
+
+        const double tSave = benchmark([&]() { image.save(filename); });
+        const double tLoad = benchmark([&]() {
+            EXRBiSpectralImage loaded(filename);
+        });
+
+        if (n == 1) {
+            tSave1 = tSave;
+            tLoad1 = tLoad;
+        }
+
+        std::cout << std::setw(8) << n << std::setw(12) << tSave << std::setw(9)
+                  << tSave1 / tSave << "x" << std::setw(12) << tLoad
+                  << std::setw(9) << tLoad1 / tLoad << "x" << std::endl;
+    }
+
+    std::remove(filename.c_str());
+
+    return 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "EXRChannelReader.h"
+#include "EXRChannelWriter.h"
+
+using namespace SEXR;
+
+const size_t N_RUNS = 3;
+
+const char *FILENAME = "benchmark-staging.exr";
+
+
+// Best time in seconds of N_RUNS runs of a function
+template<typename F>
+double benchmark(F f)
+{
+    double best = 1e30;
+
+    for (size_t run = 0; run < N_RUNS; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto end = std::chrono::steady_clock::now();
+
+        best = std::min(
+          best,
+          std::chrono::duration<double>(end - start).count());
+    }
+
+    return best;
+}
+
+
+// Writes and reads the channels of an interleaved buffer, as the
+// diagonal or the reradiation of a bispectral image
+void compare(
+  const char *              name,
+  size_t                    width,
+  size_t                    height,
+  size_t                    nChannels,
+  const SaveOptions &       options,
+  const std::vector<float> &pixels,
+  std::vector<float> &      loaded)
+{
+    const size_t xStride = sizeof(float) * nChannels;
+    const size_t yStride = xStride * width;
+
+    double tWrite[2], tRead[2];
+
+    const PlanarStaging::Transfer transfers[2]
+      = {PlanarStaging::DIRECT, PlanarStaging::STAGED};
+
+    for (int t = 0; t < 2; t++) {
+        tWrite[t] = benchmark([&]() {
+            EXRChannelWriter exrWriter(width, height);
+            exrWriter.setTransfer(transfers[t]);
+
+            for (size_t c = 0; c < nChannels; c++) {
+                exrWriter.addChannel(
+                  "T." + std::to_string(c),
+                  &pixels[c],
+                  xStride,
+                  yStride);
+            }
+
+            exrWriter.write(FILENAME, options);
+        });
+
+        tRead[t] = benchmark([&]() {
+            EXRChannelReader exrReader(FILENAME);
+            exrReader.setTransfer(transfers[t]);
+
+            for (size_t c = 0; c < nChannels; c++) {
+                exrReader.addChannel(
+                  "T." + std::to_string(c),
+                  &loaded[c],
+                  xStride,
+                  yStride);
+            }
+
+            exrReader.read();
+        });
+    }
+
+    const bool identical = std::equal(
+      pixels.begin(),
+      pixels.begin() + width * height * nChannels,
+      loaded.begin());
+
+    std::cout << std::setw(12) << name << std::setw(10) << nChannels
+              << std::setw(6)
+              << (options.layout.compression == Imf::ZIP_COMPRESSION ? "ZIP"
+                                                                     : "none")
+              << std::setw(11) << tWrite[0] << std::setw(11) << tWrite[1]
+              << std::setw(8) << tWrite[0] / tWrite[1] << "x" << std::setw(11)
+              << tRead[0] << std::setw(11) << tRead[1] << std::setw(8)
+              << tRead[0] / tRead[1] << "x" << std::setw(6)
+              << (identical ? "ok" : "FAIL") << std::endl;
+}
+
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && argc != 4) {
+        std::cerr << "Usage:" << std::endl
+                  << "------" << std::endl
+                  << argv[0] << " [<width> <height> <n_bands>]" << std::endl
+                  << std::endl
+                  << "Compares reading and writing interleaved channels "
+                     "through direct slices and planar staging."
+                  << std::endl;
+        return 0;
+    }
+
+    const size_t width  = argc > 1 ? std::stoul(argv[1]) : 512;
+    const size_t height = argc > 1 ? std::stoul(argv[2]) : 256;
+    const size_t nBands = argc > 1 ? std::stoul(argv[3]) : 31;
+
+    const size_t nReradiation = nBands * (nBands - 1) / 2;
+
+    std::vector<float> pixels(width * height * nReradiation);
+    std::vector<float> loaded(pixels.size());
+
+    for (size_t i = 0; i < pixels.size(); i++) {
+        pixels[i] = float(i % 4093) * 1e-3F;
+    }
+
+    std::cout << width << "x" << height << " pixels" << std::endl
+              << std::endl;
+
+    std::cout << std::setw(12) << "buffer" << std::setw(10) << "channels"
+              << std::setw(6) << "comp" << std::setw(11) << "write dir."
+              << std::setw(11) << "write st." << std::setw(9) << "speedup"
+              << std::setw(11) << "read dir." << std::setw(11) << "read st."
+              << std::setw(9) << "speedup" << std::endl;
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    const Imf::Compression compressions[]
+      = {Imf::NO_COMPRESSION, Imf::ZIP_COMPRESSION};
+
+    for (Imf::Compression compression : compressions) {
+        SaveOptions options;
+        options.setCompression(compression);
+
+        compare(
+          "diagonal",
+          width,
+          height,
+          nBands,
+          options,
+          pixels,
+          loaded);
+        compare(
+          "reradiation",
+          width,
+          height,
+          nReradiation,
+          options,
+          pixels,
+          loaded);
+
+        options.setTiles(64, 64);
+
+        compare(
+          "tiled rerad.",
+          width,
+          height,
+          nReradiation,
+          options,
+          pixels,
+          loaded);
+    }
+
+    std::remove(FILENAME);
+
+    return 0;
+}
@@ -53,9 +53,14 @@ int main(int argc, char *argv[])
         return 0;
     }
 
-    const EXRSpectralImage image(argv[1]);
-    const size_t           x = std::stoi(argv[2]);
-    const size_t           y = std::stoi(argv[3]);
+    const size_t x = std::stoi(argv[2]);
+    const size_t y = std::stoi(argv[3]);
+
+    // Only the requested pixel is read from the file
+    LoadOptions options;
+    options.setRegion(x, y, 1, 1);
+
+    const EXRSpectralImage image(argv[1], options);
     std::ofstream          tabularOut(argv[4]);
 
     tabularOut << "# lambda(nm) ";
@@ -72,11 +77,11 @@ int main(int argc, char *argv[])
         tabularOut << image.wavelength_nm(wl_idx);
 
         for (size_t s = 0; s < image.nStokesComponents(); s++) {
-            tabularOut << " " << image.emissive(x, y, wl_idx, s);
+            tabularOut << " " << image.emissive(0, 0, wl_idx, s);
         }
 
         if (image.isReflective()) {
-            tabularOut << " " << image.reflective(x, y, wl_idx);
+            tabularOut << " " << image.reflective(0, 0, wl_idx);
         }
 
         tabularOut << "\n";
@@ -35,6 +35,7 @@
  */
 
 #include <BiSpectralImage.h>
+#include <Threading.h>
 
 #include <sstream>
 #include <cassert>
@@ -44,7 +45,7 @@
 #include <OpenEXR/ImfChannelList.h>
 #include <OpenEXR/ImfFrameBuffer.h>
 
-#include "SpectrumConverter.h"
+#include "SpectrumConverterCache.h"
 
 namespace SEXR
 {
@@ -102,7 +103,8 @@ namespace SEXR
 
                         Imf::OutputFile exrOut(
                           filepath.str().c_str(),
-                          exrHeader);
+                          exrHeader,
+                          Threading::openEXRThreadCount());
                         exrOut.setFrameBuffer(exrFrameBuffer);
                         exrOut.writePixels(height());
                     }
@@ -112,53 +114,106 @@ namespace SEXR
     }
 
 
-    void BiSpectralImage::getRGBImage(std::vector<float> &rgbImage) const
+    void BiSpectralImage::convertRGBSpan(
+      const SpectrumConverter &sc,
+      size_t                   x,
+      size_t                   y,
+      size_t                   n,
+      float *                  rgb) const
     {
         if (!isBispectral()) {
-            SpectralImage::getRGBImage(rgbImage);
+            SpectralImage::convertRGBSpan(sc, x, y, n, rgb);
+            return;
+        }
+
+        const size_t i = y * width() + x;
+
+        if (isEmissive()) {
+            sc.spectraToRGBBatch(
+              &_reflectivePixelBuffer[nSpectralBands() * i],
+              &_reradiation[reradiationSize() * i],
+              &_emissivePixelBuffers[0][nSpectralBands() * i],
+              n,
+              rgb);
         } else {
-            rgbImage.resize(3 * width() * height());
-            SpectrumConverter sc(isEmissive());
+            sc.spectrumToRGBBatch(
+              &_reflectivePixelBuffer[nSpectralBands() * i],
+              &_reradiation[reradiationSize() * i],
+              n,
+              rgb);
+        }
+    }
 
-            std::array<float, 3> rgb;
 
-            if (isEmissive() && isReflective()) {
-                for (size_t i = 0; i < width() * height(); i++) {
-                    sc.spectraToRGB(
-                      _wavelengths_nm,
-                      &_reflectivePixelBuffer[nSpectralBands() * i],
-                      &_reradiation[reradiationSize() * i],
-                      &_emissivePixelBuffers[0][nSpectralBands() * i],
-                      rgb);
+    void BiSpectralImage::convertXYZSpan(
+      const SpectrumConverter &sc,
+      size_t                   x,
+      size_t                   y,
+      size_t                   n,
+      float *                  xyz,
+      float                    scale) const
+    {
+        if (!isBispectral()) {
+            SpectralImage::convertXYZSpan(sc, x, y, n, xyz, scale);
+            return;
+        }
 
-                    memcpy(&rgbImage[3 * i], &rgb[0], 3 * sizeof(float));
-                }
+        const size_t i = y * width() + x;
 
-                // Exposure compensation
-                for (size_t i = 0; i < width() * height(); i++) {
-                    for (size_t c = 0; c < 3; c++) {
-                        rgbImage[3 * i + c] *= std::pow(2.F, _ev);
-                    }
-                }
-            } else if (isReflective()) {
-                for (size_t i = 0; i < width() * height(); i++) {
-                    sc.spectrumToRGB(
-                      _wavelengths_nm,
-                      &_reflectivePixelBuffer[nSpectralBands() * i],
-                      &_reradiation[reradiationSize() * i],
-                      rgb);
-
-                    memcpy(&rgbImage[3 * i], &rgb[0], 3 * sizeof(float));
-                }
+        if (isEmissive()) {
+            sc.spectraToXYZBatch(
+              &_reflectivePixelBuffer[nSpectralBands() * i],
+              &_reradiation[reradiationSize() * i],
+              &_emissivePixelBuffers[0][nSpectralBands() * i],
+              n,
+              xyz,
+              scale);
+        } else {
+            sc.spectrumToXYZBatch(
+              &_reflectivePixelBuffer[nSpectralBands() * i],
+              &_reradiation[reradiationSize() * i],
+              n,
+              xyz,
+              scale);
+        }
+    }
 
-                // Exposure compensation
-                for (size_t i = 0; i < width() * height(); i++) {
-                    for (size_t c = 0; c < 3; c++) {
-                        rgbImage[3 * i + c] *= std::pow(2.F, _ev);
-                    }
-                }
-            }
+
+    SpectrumType BiSpectralImage::rgbConversionType() const
+    {
+        if (!isBispectral()) {
+            return SpectralImage::rgbConversionType();
         }
+
+        return type();
+    }
+
+
+    size_t BiSpectralImage::pixelComponents(
+      size_t        x,
+      size_t        y,
+      const float **data,
+      size_t *      sizes) const
+    {
+        if (!isBispectral()) {
+            return SpectralImage::pixelComponents(x, y, data, sizes);
+        }
+
+        const size_t i = y * width() + x;
+
+        data[0]  = &_reflectivePixelBuffer[nSpectralBands() * i];
+        sizes[0] = nSpectralBands();
+        data[1]  = &_reradiation[reradiationSize() * i];
+        sizes[1] = reradiationSize();
+
+        if (isEmissive()) {
+            data[2]  = &_emissivePixelBuffers[0][nSpectralBands() * i];
+            sizes[2] = nSpectralBands();
+
+            return 3;
+        }
+
+        return 2;
     }
 
 
@@ -225,6 +280,8 @@ namespace SEXR
         assert(isBispectral());
         assert(_reradiation.size() == reradiationSize() * width() * height());
 
+        invalidatePreview(x, y);
+
         size_t reradIdx
           = idxFromWavelengthIdx(wavelengthFrom_idx, wavelengthTo_idx);
 
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ColorOutput.h>
+
+#include "spectrum_data.h"
+
+#include <cstring>
+
+namespace SEXR
+{
+    ColorOutput::ColorOutput(Type type): _type(type)
+    {
+        memcpy(&_matrix[0], XYZ_TO_SRGB_D65_MATRIX, 9 * sizeof(float));
+    }
+
+
+    ColorOutput::ColorOutput(const std::array<float, 9> &xyzToRgb)
+      : _type(RGB)
+      , _matrix(xyzToRgb)
+    {}
+
+
+    ColorOutput ColorOutput::sRGB() { return ColorOutput(RGB); }
+
+
+    ColorOutput ColorOutput::rec2020()
+    {
+        std::array<float, 9> matrix;
+        memcpy(&matrix[0], XYZ_TO_REC2020_D65_MATRIX, 9 * sizeof(float));
+
+        return ColorOutput(matrix);
+    }
+
+
+    ColorOutput ColorOutput::ACEScg()
+    {
+        std::array<float, 9> matrix;
+        memcpy(&matrix[0], XYZ_TO_ACESCG_D65_MATRIX, 9 * sizeof(float));
+
+        return ColorOutput(matrix);
+    }
+
+
+    size_t ColorOutput::nChannels() const
+    {
+        switch (_type) {
+            case LUMINANCE:
+                return 1;
+            case CHROMATICITY:
+                return 2;
+            default:
+                return 3;
+        }
+    }
+
+}   // namespace SEXR
@@ -0,0 +1,488 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Colorimetry.h>
+
+#include "ColorimetryTables.h"
+#include "SpectrumConverterCache.h"
+#include "Util.h"
+#include "spectrum_data.h"
+
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <regex>
+
+namespace SEXR
+{
+    namespace
+    {
+        struct Catalogue {
+            Catalogue();
+
+            std::mutex mutex;
+
+            std::vector<std::shared_ptr<const ObserverTable>>   observers;
+            std::vector<std::shared_ptr<const IlluminantTable>> illuminants;
+        };
+
+
+        Catalogue &catalogue()
+        {
+            static Catalogue instance;
+            return instance;
+        }
+
+
+        // Resamples linearly the values every nanometer between the
+        // first and last integer wavelengths covered
+        void resample(
+          const std::vector<float> &wavelengths_nm,
+          const std::vector<float> &values,
+          float &                   firstWavelength_nm,
+          std::vector<float> &      resampled)
+        {
+            if (wavelengths_nm.size() < 2
+                || values.size() != wavelengths_nm.size()) {
+                throw Colorimetry::INVALID_DATA;
+            }
+
+            for (size_t i = 0; i < wavelengths_nm.size() - 1; i++) {
+                if (!(wavelengths_nm[i] < wavelengths_nm[i + 1])) {
+                    throw Colorimetry::INVALID_DATA;
+                }
+            }
+
+            const float first = std::ceil(wavelengths_nm.front());
+            const float last  = std::floor(wavelengths_nm.back());
+
+            if (last < first) {
+                throw Colorimetry::INVALID_DATA;
+            }
+
+            resampled.resize(size_t(last - first) + 1);
+
+            size_t idx = 0;
+
+            for (size_t i = 0; i < resampled.size(); i++) {
+                const float wl = first + float(i);
+
+                while (idx + 2 < wavelengths_nm.size()
+                       && wavelengths_nm[idx + 1] < wl) {
+                    idx++;
+                }
+
+                resampled[i] = Util::interp(
+                  wl,
+                  wavelengths_nm[idx],
+                  wavelengths_nm[idx + 1],
+                  values[idx],
+                  values[idx + 1]);
+            }
+
+            firstWavelength_nm = first;
+        }
+
+
+        std::shared_ptr<const IlluminantTable> makeIlluminant(
+          const std::vector<float> &wavelengths_nm,
+          const std::vector<float> &values)
+        {
+            std::shared_ptr<IlluminantTable> table
+              = std::make_shared<IlluminantTable>();
+
+            resample(
+              wavelengths_nm,
+              values,
+              table->firstWavelength_nm,
+              table->spd);
+
+            return table;
+        }
+
+
+        // Wavelengths of a table sampled at a regular step
+        std::vector<float>
+        sampledWavelengths(float first_nm, float step_nm, size_t nSamples)
+        {
+            std::vector<float> wavelengths_nm(nSamples);
+
+            for (size_t i = 0; i < nSamples; i++) {
+                wavelengths_nm[i] = first_nm + float(i) * step_nm;
+            }
+
+            return wavelengths_nm;
+        }
+
+
+        // CIE 1964 standard observer, resampled every nanometer
+        std::shared_ptr<const ObserverTable> cie1964Observer()
+        {
+            const std::vector<float> wavelengths_nm = sampledWavelengths(
+              CIE1964_10DEG_FIRST_WAVELENGTH_NM,
+              CIE1964_10DEG_WAVELENGTH_STEP_NM,
+              sizeof(CIE1964_10DEG_X) / sizeof(CIE1964_10DEG_X[0]));
+
+            const float *xyz[3]
+              = {CIE1964_10DEG_X, CIE1964_10DEG_Y, CIE1964_10DEG_Z};
+
+            std::shared_ptr<ObserverTable> table
+              = std::make_shared<ObserverTable>();
+
+            for (size_t c = 0; c < 3; c++) {
+                resample(
+                  wavelengths_nm,
+                  std::vector<float>(xyz[c], xyz[c] + wavelengths_nm.size()),
+                  table->firstWavelength_nm,
+                  table->xyz[c]);
+            }
+
+            return table;
+        }
+
+
+        // CIE fluorescent illuminant, resampled every nanometer
+        template<size_t N>
+        std::shared_ptr<const IlluminantTable>
+        fluorescentIlluminant(const float (&spd)[N])
+        {
+            return makeIlluminant(
+              sampledWavelengths(
+                CIE_F_FIRST_WAVELENGTH_NM,
+                CIE_F_WAVELENGTH_STEP_NM,
+                N),
+              std::vector<float>(std::begin(spd), std::end(spd)));
+        }
+
+
+        // CIE daylight for a correlated colour temperature in Kelvin
+        std::shared_ptr<const IlluminantTable> daylightIlluminant(double T)
+        {
+            // Chromaticity of the daylight locus
+            const double xD
+              = (T <= 7000.)
+                  ? -4.6070e9 / (T * T * T) + 2.9678e6 / (T * T)
+                      + 0.09911e3 / T + 0.244063
+                  : -2.0064e9 / (T * T * T) + 1.9018e6 / (T * T)
+                      + 0.24748e3 / T + 0.237040;
+            const double yD = -3.000 * xD * xD + 2.870 * xD - 0.275;
+
+            // The CIE rounds the factors to 3 decimals
+            const double M  = 0.0241 + 0.2562 * xD - 0.7341 * yD;
+            const double M1 = std::round(
+                                1000. * (-1.3515 - 1.7703 * xD + 5.9114 * yD)
+                                / M)
+                              / 1000.;
+            const double M2 = std::round(
+                                1000. * (0.0300 - 31.4424 * xD + 30.0717 * yD)
+                                / M)
+                              / 1000.;
+
+            const size_t nSamples
+              = sizeof(CIE_DAYLIGHT_S0) / sizeof(CIE_DAYLIGHT_S0[0]);
+
+            std::vector<float> wavelengths_nm(nSamples);
+            std::vector<float> values(nSamples);
+
+            for (size_t i = 0; i < nSamples; i++) {
+                wavelengths_nm[i]
+                  = CIE_DAYLIGHT_FIRST_WAVELENGTH_NM
+                    + float(i) * CIE_DAYLIGHT_WAVELENGTH_STEP_NM;
+                values[i] = float(
+                  CIE_DAYLIGHT_S0[i] + M1 * CIE_DAYLIGHT_S1[i]
+                  + M2 * CIE_DAYLIGHT_S2[i]);
+            }
+
+            return makeIlluminant(wavelengths_nm, values);
+        }
+
+
+        // CIE standard illuminant A: a Planckian radiator normalised
+        // to 100 at 560 nm
+        std::shared_ptr<const IlluminantTable> illuminantA()
+        {
+            std::shared_ptr<IlluminantTable> table
+              = std::make_shared<IlluminantTable>();
+
+            table->firstWavelength_nm = 300.F;
+            table->spd.resize(531);
+
+            const double c = 1.435e7 / 2848.;
+
+            for (size_t i = 0; i < table->spd.size(); i++) {
+                const double wl = table->firstWavelength_nm + double(i);
+
+                table->spd[i] = float(
+                  100. * std::pow(560. / wl, 5.)
+                  * (std::exp(c / 560.) - 1.) / (std::exp(c / wl) - 1.));
+            }
+
+            return table;
+        }
+
+
+        // CIE standard illuminant E: equal energy
+        std::shared_ptr<const IlluminantTable> illuminantE()
+        {
+            std::shared_ptr<IlluminantTable> table
+              = std::make_shared<IlluminantTable>();
+
+            table->firstWavelength_nm = 300.F;
+            table->spd.assign(531, 100.F);
+
+            return table;
+        }
+
+
+        Catalogue::Catalogue()
+        {
+            std::shared_ptr<ObserverTable> cie1931
+              = std::make_shared<ObserverTable>();
+
+            cie1931->firstWavelength_nm = CIE1931_2DEG_FIRST_WAVELENGTH_NM;
+            cie1931->xyz[0] = std::vector<float>(
+              std::begin(CIE1931_2DEG_X),
+              std::end(CIE1931_2DEG_X));
+            cie1931->xyz[1] = std::vector<float>(
+              std::begin(CIE1931_2DEG_Y),
+              std::end(CIE1931_2DEG_Y));
+            cie1931->xyz[2] = std::vector<float>(
+              std::begin(CIE1931_2DEG_Z),
+              std::end(CIE1931_2DEG_Z));
+
+            // Same order as Colorimetry::BuiltinObservers
+            observers.push_back(cie1931);
+            observers.push_back(cie1964Observer());
+
+            std::shared_ptr<IlluminantTable> d65
+              = std::make_shared<IlluminantTable>();
+
+            d65->firstWavelength_nm = D_65_FIRST_WAVELENGTH_NM;
+            d65->spd                = std::vector<float>(
+              std::begin(D_65_SPD),
+              std::end(D_65_SPD));
+
+            // Same order as Colorimetry::BuiltinIlluminants. The
+            // nominal temperatures are corrected for the change of
+            // the c2 constant to 1.4388e-2 m.K
+            illuminants.push_back(d65);
+            illuminants.push_back(daylightIlluminant(5000. * 1.4388 / 1.438));
+            illuminants.push_back(daylightIlluminant(5500. * 1.4388 / 1.438));
+            illuminants.push_back(daylightIlluminant(7500. * 1.4388 / 1.438));
+            illuminants.push_back(illuminantA());
+            illuminants.push_back(illuminantE());
+            illuminants.push_back(fluorescentIlluminant(CIE_F2_SPD));
+            illuminants.push_back(fluorescentIlluminant(CIE_F7_SPD));
+            illuminants.push_back(fluorescentIlluminant(CIE_F11_SPD));
+        }
+
+
+        // Reads the lines of a CSV file holding nColumns numbers
+        void loadCSV(
+          const std::string &              filename,
+          size_t                           nColumns,
+          std::vector<std::vector<float>> &columns)
+        {
+            std::ifstream inFile(filename);
+
+            if (!inFile) {
+                throw Colorimetry::READ_ERROR;
+            }
+
+            const std::string floatRegex
+              = "\\s*([-+]?(?:\\d+\\.?\\d*|\\.\\d+)(?:[Ee][-+]?\\d+)?)\\s*";
+
+            std::string lineRegex = floatRegex;
+
+            for (size_t c = 1; c < nColumns; c++) {
+                lineRegex += "," + floatRegex;
+            }
+
+            const std::regex e(lineRegex);
+            std::string      line;
+
+            columns.assign(nColumns, std::vector<float>());
+
+            while (std::getline(inFile, line)) {
+                std::smatch matches;
+
+                if (std::regex_match(line, matches, e)) {
+                    for (size_t c = 0; c < nColumns; c++) {
+                        columns[c].push_back(std::stof(matches[c + 1]));
+                    }
+                }
+            }
+
+            if (columns[0].size() < 2) {
+                throw Colorimetry::INCORRECT_FORMED_FILE;
+            }
+        }
+    }   // namespace
+
+
+    size_t Colorimetry::loadObserver(const std::string &filename)
+    {
+        std::vector<std::vector<float>> columns;
+        loadCSV(filename, 4, columns);
+
+        const std::array<std::vector<float>, 3> xyz
+          = {columns[1], columns[2], columns[3]};
+
+        try {
+            return addObserver(columns[0], xyz);
+        } catch (Errors) {
+            throw INCORRECT_FORMED_FILE;
+        }
+    }
+
+
+    size_t Colorimetry::loadIlluminant(const std::string &filename)
+    {
+        std::vector<std::vector<float>> columns;
+        loadCSV(filename, 2, columns);
+
+        try {
+            return addIlluminant(columns[0], columns[1]);
+        } catch (Errors) {
+            throw INCORRECT_FORMED_FILE;
+        }
+    }
+
+
+    size_t Colorimetry::addObserver(
+      const std::vector<float> &               wavelengths_nm,
+      const std::array<std::vector<float>, 3> &xyz)
+    {
+        std::shared_ptr<ObserverTable> table
+          = std::make_shared<ObserverTable>();
+
+        for (size_t c = 0; c < 3; c++) {
+            resample(
+              wavelengths_nm,
+              xyz[c],
+              table->firstWavelength_nm,
+              table->xyz[c]);
+        }
+
+        Catalogue &                 cat = catalogue();
+        std::lock_guard<std::mutex> lock(cat.mutex);
+
+        cat.observers.push_back(table);
+
+        return cat.observers.size() - 1;
+    }
+
+
+    size_t Colorimetry::addIlluminant(
+      const std::vector<float> &wavelengths_nm,
+      const std::vector<float> &values)
+    {
+        std::shared_ptr<const IlluminantTable> table
+          = makeIlluminant(wavelengths_nm, values);
+
+        Catalogue &                 cat = catalogue();
+        std::lock_guard<std::mutex> lock(cat.mutex);
+
+        cat.illuminants.push_back(table);
+
+        return cat.illuminants.size() - 1;
+    }
+
+
+    size_t Colorimetry::nObservers()
+    {
+        Catalogue &                 cat = catalogue();
+        std::lock_guard<std::mutex> lock(cat.mutex);
+
+        return cat.observers.size();
+    }
+
+
+    size_t Colorimetry::nIlluminants()
+    {
+        Catalogue &                 cat = catalogue();
+        std::lock_guard<std::mutex> lock(cat.mutex);
+
+        return cat.illuminants.size();
+    }
+
+
+    void Colorimetry::setConverterCacheBudget(size_t bytes)
+    {
+        SpectrumConverterCache::setMemoryBudget(bytes);
+    }
+
+
+    size_t Colorimetry::converterCacheBudget()
+    {
+        return SpectrumConverterCache::memoryBudget();
+    }
+
+
+    size_t Colorimetry::converterCacheUsage()
+    {
+        return SpectrumConverterCache::memoryUsage();
+    }
+
+
+    std::shared_ptr<const ObserverTable>
+    ColorimetryTables::observer(size_t index)
+    {
+        Catalogue &                 cat = catalogue();
+        std::lock_guard<std::mutex> lock(cat.mutex);
+
+        if (index >= cat.observers.size()) {
+            throw Colorimetry::INVALID_INDEX;
+        }
+
+        return cat.observers[index];
+    }
+
+
+    std::shared_ptr<const IlluminantTable>
+    ColorimetryTables::illuminant(size_t index)
+    {
+        Catalogue &                 cat = catalogue();
+        std::lock_guard<std::mutex> lock(cat.mutex);
+
+        if (index >= cat.illuminants.size()) {
+            throw Colorimetry::INVALID_INDEX;
+        }
+
+        return cat.illuminants[index];
+    }
+
+}   // namespace SEXR
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace SEXR
+{
+    // Tables are sampled every nanometer
+    struct ObserverTable {
+        float                             firstWavelength_nm;
+        std::array<std::vector<float>, 3> xyz;
+    };
+
+    struct IlluminantTable {
+        float              firstWavelength_nm;
+        std::vector<float> spd;
+    };
+
+    class ColorimetryTables
+    {
+      public:
+        /**
+         * Gets the colour matching functions of an observer from the
+         * Colorimetry catalogue. Throws Colorimetry::INVALID_INDEX
+         * for an unknown observer.
+         */
+        static std::shared_ptr<const ObserverTable> observer(size_t index);
+
+        /**
+         * Gets the spectral power distribution of an illuminant from
+         * the Colorimetry catalogue. Throws Colorimetry::INVALID_INDEX
+         * for an unknown illuminant.
+         */
+        static std::shared_ptr<const IlluminantTable> illuminant(size_t index);
+    };
+
+}   // namespace SEXR
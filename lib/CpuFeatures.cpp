@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "CpuFeatures.h"
+
+#ifdef SEXR_X86_KERNELS
+#    if defined(_MSC_VER) && !defined(__clang__)
+#        include <intrin.h>
+#    else
+#        include <cpuid.h>
+#    endif
+#endif
+
+namespace SEXR
+{
+    struct Features
+    {
+        bool sse41;
+        bool avx;
+        bool f16c;
+        bool fma;
+        bool avx2;
+        bool avx512f;
+    };
+
+
+    static Features detectFeatures()
+    {
+        Features f = {false, false, false, false, false, false};
+
+#if defined(SEXR_X86_KERNELS) && defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+
+        __cpuid(info, 0);
+        const int nIds = info[0];
+
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+
+        // The OS must save the AVX (and AVX-512) registers
+        const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+        const bool               avxOS    = (xcr0 & 0x6) == 0x6;
+        const bool               avx512OS = (xcr0 & 0xe6) == 0xe6;
+
+        f.sse41 = (info[2] & (1 << 19)) != 0;
+        f.avx   = avxOS && (info[2] & (1 << 28)) != 0;
+        f.f16c  = avxOS && (info[2] & (1 << 29)) != 0;
+        f.fma   = avxOS && (info[2] & (1 << 12)) != 0;
+
+        if (nIds >= 7) {
+            __cpuidex(info, 7, 0);
+            f.avx2    = avxOS && (info[1] & (1 << 5)) != 0;
+            f.avx512f = avx512OS && (info[1] & (1 << 16)) != 0;
+        }
+#elif defined(SEXR_X86_KERNELS)
+        // The checks of the AVX based sets include the OS support of
+        // the registers
+        __builtin_cpu_init();
+
+        f.sse41   = __builtin_cpu_supports("sse4.1");
+        f.avx     = __builtin_cpu_supports("avx");
+        f.fma     = __builtin_cpu_supports("fma");
+        f.avx2    = __builtin_cpu_supports("avx2");
+        f.avx512f = __builtin_cpu_supports("avx512f");
+
+        // Not known by all compilers' __builtin_cpu_supports
+        unsigned int eax, ebx, ecx, edx;
+
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            f.f16c = f.avx && (ecx & bit_F16C) != 0;
+        }
+#endif
+        return f;
+    }
+
+
+    static const Features &features()
+    {
+        static const Features f = detectFeatures();
+        return f;
+    }
+
+
+    bool CpuFeatures::hasSSE41() { return features().sse41; }
+
+
+    bool CpuFeatures::hasAVX() { return features().avx; }
+
+
+    bool CpuFeatures::hasF16C() { return features().f16c; }
+
+
+    bool CpuFeatures::hasFMA() { return features().fma; }
+
+
+    bool CpuFeatures::hasAVX2() { return features().avx2; }
+
+
+    bool CpuFeatures::hasAVX512F() { return features().avx512f; }
+
+}   // namespace SEXR
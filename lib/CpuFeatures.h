@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+// Kernels are compiled for every instruction set the compiler knows
+// of, and selected at runtime with CpuFeatures. SEXR_TARGET enables an
+// instruction set for a single function.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) \
+  || defined(_M_IX86)
+#    define SEXR_X86_KERNELS
+#    include <immintrin.h>
+#    if defined(_MSC_VER) && !defined(__clang__)
+#        define SEXR_TARGET(isa)
+#    else
+#        define SEXR_TARGET(isa) __attribute__((target(isa)))
+#    endif
+#elif defined(__aarch64__)
+#    define SEXR_NEON_KERNELS
+#    include <arm_neon.h>
+#endif
+
+namespace SEXR
+{
+    /**
+     * Instruction sets of the running CPU. An instruction set using
+     * the AVX registers is only reported when the OS saves them. The
+     * CPU is queried once, all functions return false on other
+     * architectures than x86.
+     */
+    class CpuFeatures
+    {
+      public:
+        static bool hasSSE41();
+        static bool hasAVX();
+        static bool hasF16C();
+        static bool hasFMA();
+        static bool hasAVX2();
+        static bool hasAVX512F();
+    };
+
+}   // namespace SEXR
@@ -36,16 +36,19 @@
 
 #include <EXRBiSpectralImage.h>
 #include "Util.h"
+#include "EXRChannelReader.h"
+#include "EXRChannelWriter.h"
+#include "Quantisation.h"
+#include "EXRChannelName.h"
 
-#include <regex>
 #include <algorithm>
-#include <sstream>
 #include <cassert>
 
 #include <OpenEXR/ImfInputFile.h>
 #include <OpenEXR/ImfOutputFile.h>
 #include <OpenEXR/ImfChannelList.h>
 #include <OpenEXR/ImfStringAttribute.h>
+#include <OpenEXR/ImfFloatVectorAttribute.h>
 #include <OpenEXR/ImfFrameBuffer.h>
 
 namespace SEXR
@@ -60,150 +63,36 @@ namespace SEXR
     {}
 
 
-    EXRBiSpectralImage::EXRBiSpectralImage(const std::string &filename)
+    EXRBiSpectralImage::EXRBiSpectralImage(
+      const std::string &filename, const LoadOptions &options)
       : BiSpectralImage()
     {
-        Imf::InputFile      exrIn(filename.c_str());
-        const Imf::Header & exrHeader     = exrIn.header();
-        const Imath::Box2i &exrDataWindow = exrHeader.dataWindow();
-
-        _width        = exrDataWindow.max.x - exrDataWindow.min.x + 1;
-        _height       = exrDataWindow.max.y - exrDataWindow.min.y + 1;
-        _spectrumType = SpectrumType::UNDEFINED;
+        EXRChannelReader   exrReader(filename);
+        const Imf::Header &exrHeader = exrReader.header();
 
-        // --------------------------------------------------------------------
-        // Determine channels' position
-        // --------------------------------------------------------------------
+        exrReader.setLevel(options.level);
 
-        const Imf::ChannelList &exrChannels = exrHeader.channels();
-
-        std::array<std::vector<std::pair<float, std::string>>, 4>
-                                                   wavelengths_nm_S;
-        std::vector<std::pair<float, std::string>> wavelengths_nm_diagonal;
-        std::vector<std::pair<std::pair<float, float>, std::string>>
-          reradiation_wavelengths_nm;
-
-        for (Imf::ChannelList::ConstIterator channel = exrChannels.begin();
-             channel != exrChannels.end();
-             channel++) {
-            // Check if the channel is a spectral or a bispectral one
-            int    polarisationComponent;
-            double in_wavelength_nm, out_wavelength_nm;
-
-            SpectrumType currChannelType = channelType(
-              channel.name(),
-              polarisationComponent,
-              in_wavelength_nm,
-              out_wavelength_nm);
-
-            if (currChannelType != SpectrumType::UNDEFINED) {
-                _spectrumType = _spectrumType | currChannelType;
-
-                if (isReflectiveSpectrum(currChannelType)) {
-                    if (!isBispectralSpectrum(currChannelType)) {
-                        wavelengths_nm_diagonal.push_back(
-                          std::make_pair(in_wavelength_nm, channel.name()));
-                    } else {
-                        reradiation_wavelengths_nm.push_back(std::make_pair(
-                          std::make_pair(in_wavelength_nm, out_wavelength_nm),
-                          channel.name()));
-                    }
-                } else if (isEmissiveSpectrum(currChannelType)) {
-                    assert(polarisationComponent < 4);
-                    wavelengths_nm_S[polarisationComponent].push_back(
-                      std::make_pair(in_wavelength_nm, channel.name()));
-                }
-            }
-        }
+        const Imath::Box2i exrDataWindow = exrReader.dataWindow();
 
-        // Sort by ascending wavelengths
-        for (size_t s = 0; s < nStokesComponents(); s++) {
-            std::sort(wavelengths_nm_S[s].begin(), wavelengths_nm_S[s].end());
-        }
+        const Imath::Box2i exrRegion
+          = EXRChannelReader::loadRegion(exrDataWindow, options);
 
-        std::sort(
-          wavelengths_nm_diagonal.begin(),
-          wavelengths_nm_diagonal.end());
-
-        struct {
-            bool operator()(
-              std::pair<std::pair<float, float>, std::string> a,
-              std::pair<std::pair<float, float>, std::string> b) const
-            {
-                if (a.first.first == b.first.first) {
-                    return a.first.second < b.first.second;
-                } else {
-                    return a.first.first < b.first.first;
-                }
-            }
-        } sortBispectral;
+        _width  = exrRegion.max.x - exrRegion.min.x + 1;
+        _height = exrRegion.max.y - exrRegion.min.y + 1;
 
-        std::sort(
-          reradiation_wavelengths_nm.begin(),
-          reradiation_wavelengths_nm.end(),
-          sortBispectral);
+        invalidatePreview();
 
         // --------------------------------------------------------------------
-        // Sanity check
+        // Determine channels' position
         // --------------------------------------------------------------------
 
-        if (_spectrumType == SpectrumType::UNDEFINED) {
-            // Probably an RGB EXR, not our job to handle it
-            throw INCORRECT_FORMED_FILE;
-        }
-
-        if (isEmissive()) {
-            // Check we have the same wavelength for each Stokes component
-            // Wavelength vectors must be of the same size
-            const float base_size_emissive = wavelengths_nm_S[0].size();
+        const EXRChannelReader::SpectralChannels channels
+          = EXRChannelReader::spectralChannels(exrHeader, true, options);
 
-            for (size_t s = 1; s < nStokesComponents(); s++) {
-                if (wavelengths_nm_S[s].size() != base_size_emissive) {
-                    throw INCORRECT_FORMED_FILE;
-                }
+        _spectrumType   = channels.type;
+        _wavelengths_nm = channels.wavelengths_nm;
 
-                // Wavelengths must correspond
-                for (size_t wl_idx = 0; wl_idx < base_size_emissive; wl_idx++) {
-                    if (
-                      wavelengths_nm_S[s][wl_idx].first
-                      != wavelengths_nm_S[0][wl_idx].first) {
-                        throw INCORRECT_FORMED_FILE;
-                    }
-                }
-            }
-        }
-
-        // If both reflective and emissive, we need to perform a last sanity check
-        if (isEmissive() && isReflective()) {
-            const size_t n_emissive_wavelengths = wavelengths_nm_S[0].size();
-            const size_t n_reflective_wavelengths
-              = wavelengths_nm_diagonal.size();
-
-            if (n_emissive_wavelengths != n_reflective_wavelengths)
-                throw INCORRECT_FORMED_FILE;
-
-            for (size_t wl_idx = 0; wl_idx < n_emissive_wavelengths; wl_idx++) {
-                if (
-                  wavelengths_nm_S[0][wl_idx]
-                  != wavelengths_nm_diagonal[wl_idx])
-                    throw INCORRECT_FORMED_FILE;
-            }
-        }
-
-        // Now, we can populate the local wavelength vector
-        if (isEmissive()) {
-            _wavelengths_nm.reserve(wavelengths_nm_S[0].size());
-
-            for (const auto &wl_index : wavelengths_nm_S[0]) {
-                _wavelengths_nm.push_back(wl_index.first);
-            }
-        } else {
-            _wavelengths_nm.reserve(wavelengths_nm_diagonal.size());
-
-            for (const auto &wl_index : wavelengths_nm_diagonal) {
-                _wavelengths_nm.push_back(wl_index.first);
-            }
-        }
+        const auto &reradiation_wavelengths_nm = channels.reradiation;
 
         // Check every single reradiation have all upper wavelength
         // values
@@ -272,9 +161,7 @@ namespace SEXR
         // Read the pixel data
         // ---------------------------------------------------------------------
 
-        Imf::FrameBuffer exrFrameBuffer;
-
-        const Imf::PixelType compType = Imf::FLOAT;
+        exrReader.setRegion(exrRegion);
 
         // Set the diagonal for reading
         const size_t xStride = sizeof(float) * nSpectralBands();
@@ -282,33 +169,24 @@ namespace SEXR
 
         for (size_t s = 0; s < nStokesComponents(); s++) {
             for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
-                char *     ptrS  = (char *)(&_emissivePixelBuffers[s][wl_idx]);
-                Imf::Slice slice = Imf::Slice::Make(
-                  compType,
-                  ptrS,
-                  exrDataWindow,
+                exrReader.addChannel(
+                  channels.emissive[s][wl_idx].second,
+                  &_emissivePixelBuffers[s][wl_idx],
                   xStride,
-                  yStride);
-
-                exrFrameBuffer.insert(
-                  wavelengths_nm_S[s][wl_idx].second,
-                  slice);
+                  yStride,
+                  channels.emissiveScales[wl_idx]);
             }
         }
 
         if (isReflective()) {
             for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
-                char *     ptrS  = (char *)(&_reflectivePixelBuffer[wl_idx]);
-                Imf::Slice slice = Imf::Slice::Make(
-                  compType,
-                  ptrS,
-                  exrDataWindow,
+                exrReader.addChannel(
+                  channels.reflective[wl_idx].second,
+                  &_reflectivePixelBuffer[wl_idx],
                   xStride,
-                  yStride);
-
-                exrFrameBuffer.insert(
-                  wavelengths_nm_diagonal[wl_idx].second,
-                  slice);
+                  yStride,
+                  channels.reflectiveScale,
+                  channels.reflectiveOffset);
             }
 
             if (isBispectral()) {
@@ -317,25 +195,42 @@ namespace SEXR
                   = sizeof(float) * reradiationSize();
                 const size_t yStrideReradiation = xStrideReradiation * width();
 
-                for (size_t rr = 0; rr < reradiationSize(); rr++) {
-                    char *     framebuffer = (char *)(&_reradiation[rr]);
-                    Imf::Slice slice       = Imf::Slice::Make(
-                      compType,
-                      framebuffer,
-                      exrDataWindow,
-                      xStrideReradiation,
-                      yStrideReradiation);
+                // Each channel is stored at the place given by its
+                // wavelengths
+                for (const auto &rerad : reradiation_wavelengths_nm) {
+                    const size_t wlFrom_idx
+                      = std::lower_bound(
+                          _wavelengths_nm.begin(),
+                          _wavelengths_nm.end(),
+                          rerad.first.first)
+                        - _wavelengths_nm.begin();
+                    const size_t wlTo_idx
+                      = std::lower_bound(
+                          _wavelengths_nm.begin(),
+                          _wavelengths_nm.end(),
+                          rerad.first.second)
+                        - _wavelengths_nm.begin();
+
+                    // Skips the reradiation of unknown wavelengths
+                    if (
+                      wlTo_idx >= nSpectralBands() || wlFrom_idx >= wlTo_idx
+                      || wavelength_nm(wlFrom_idx) != rerad.first.first
+                      || wavelength_nm(wlTo_idx) != rerad.first.second) {
+                        continue;
+                    }
 
-                    exrFrameBuffer.insert(
-                      reradiation_wavelengths_nm[reradiationSize() - rr - 1]
-                        .second,
-                      slice);
+                    exrReader.addChannel(
+                      rerad.second,
+                      &_reradiation[idxFromWavelengthIdx(wlFrom_idx, wlTo_idx)],
+                      xStrideReradiation,
+                      yStrideReradiation,
+                      channels.reradiationScale,
+                      channels.reradiationOffset);
                 }
             }
         }
 
-        exrIn.setFrameBuffer(exrFrameBuffer);
-        exrIn.readPixels(exrDataWindow.min.y, exrDataWindow.max.y);
+        exrReader.read();
 
         // ---------------------------------------------------------------------
         // Read metadata
@@ -399,10 +294,16 @@ namespace SEXR
         // Each channel sensitivity
         _channelSensitivities.resize(nSpectralBands());
 
-        for (size_t i = 0; i < wavelengths_nm_S[0].size(); i++) {
+        for (size_t i = 0; i < nSpectralBands(); i++) {
+            // Files without emissive channels may still name them
+            const std::string channelName
+              = i < channels.emissive[0].size()
+                  ? channels.emissive[0][i].second
+                  : getEmissiveChannelName(0, _wavelengths_nm[i]);
+
             const Imf::StringAttribute *filterTransmissionAttr
               = exrHeader.findTypedAttribute<Imf::StringAttribute>(
-                wavelengths_nm_S[0][i].second);
+                channelName);
 
             if (filterTransmissionAttr != nullptr) {
                 try {
@@ -446,17 +347,20 @@ namespace SEXR
 
     void EXRBiSpectralImage::save(const std::string &filename) const
     {
-        Imf::Header       exrHeader(width(), height());
-        Imf::ChannelList &exrChannels = exrHeader.channels();
+        save(filename, SaveOptions());
+    }
+
+
+    void EXRBiSpectralImage::save(
+      const std::string &filename, const SaveOptions &options) const
+    {
+        EXRChannelWriter exrWriter(width(), height());
+        Imf::Header &    exrHeader = exrWriter.header();
 
         // ---------------------------------------------------------------------
         // Write the pixel data
         // ---------------------------------------------------------------------
 
-        // Layout framebuffer
-        Imf::FrameBuffer     exrFrameBuffer;
-        const Imf::PixelType compType = Imf::FLOAT;
-
         // Write RGB version
         std::vector<float> rgbImage;
         getRGBImage(rgbImage);
@@ -466,45 +370,100 @@ namespace SEXR
         const size_t                     yStrideRGB  = xStrideRGB * width();
 
         for (size_t c = 0; c < 3; c++) {
-            char *ptrRGB = (char *)(&rgbImage[c]);
-            exrChannels.insert(rgbChannels[c], Imf::Channel(compType));
-            exrFrameBuffer.insert(
+            exrWriter.addChannel(
               rgbChannels[c],
-              Imf::Slice(compType, ptrRGB, xStrideRGB, yStrideRGB));
+              &rgbImage[c],
+              xStrideRGB,
+              yStrideRGB);
         }
 
         // Write spectral version
         const size_t xStride = sizeof(float) * nSpectralBands();
         const size_t yStride = xStride * width();
 
+        // Emissive values are not bounded
+        if (options.emissiveType == Imf::UINT) {
+            throw INVALID_OPTIONS;
+        }
+
+        // HALF emissive bands may be scaled to fit the HALF range
+        std::vector<float> emissiveScales(nSpectralBands(), 1.F);
+
+        if (
+          isEmissive() && options.emissiveType == Imf::HALF
+          && options.scaleEmissive) {
+            emissiveScales = EXRChannelWriter::halfScales(
+              _emissivePixelBuffers.data(),
+              nStokesComponents(),
+              nSpectralBands());
+
+            exrHeader.insert(
+              EMISSIVE_SCALE_ATTR,
+              Imf::FloatVectorAttribute(emissiveScales));
+        }
+
         for (size_t s = 0; s < nStokesComponents(); s++) {
             for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
                 // Populate channel name
                 const std::string channelName
                   = getEmissiveChannelName(s, _wavelengths_nm[wl_idx]);
-                exrChannels.insert(channelName, Imf::Channel(compType));
-
-                char *ptrS = (char *)(&_emissivePixelBuffers[s][wl_idx]);
-                exrFrameBuffer.insert(
+                exrWriter.addChannel(
                   channelName,
-                  Imf::Slice(compType, ptrS, xStride, yStride));
+                  &_emissivePixelBuffers[s][wl_idx],
+                  xStride,
+                  yStride,
+                  options.emissiveType,
+                  emissiveScales[wl_idx]);
             }
         }
 
         if (isReflective()) {
+            // Quantised values are stored with their range
+            float reflectiveScale = 1.F, reflectiveOffset = 0.F;
+
+            if (options.reflectiveType == Imf::UINT) {
+                Quantisation::range(
+                  _reflectivePixelBuffer.data(),
+                  _reflectivePixelBuffer.size(),
+                  reflectiveScale,
+                  reflectiveOffset);
+
+                exrHeader.insert(
+                  REFLECTIVE_QUANTISATION_ATTR,
+                  Imf::FloatVectorAttribute(
+                    std::vector<float>({reflectiveScale, reflectiveOffset})));
+            }
+
             for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
                 // Populate channel name
                 const std::string channelName
                   = getReflectiveChannelName(_wavelengths_nm[wl_idx]);
-                exrChannels.insert(channelName, Imf::Channel(compType));
-
-                char *ptrS = (char *)(&_reflectivePixelBuffer[wl_idx]);
-                exrFrameBuffer.insert(
+                exrWriter.addChannel(
                   channelName,
-                  Imf::Slice(compType, ptrS, xStride, yStride));
+                  &_reflectivePixelBuffer[wl_idx],
+                  xStride,
+                  yStride,
+                  options.reflectiveType,
+                  reflectiveScale,
+                  reflectiveOffset);
             }
 
             if (isBispectral()) {
+                float reradiationScale = 1.F, reradiationOffset = 0.F;
+
+                if (options.reradiationType == Imf::UINT) {
+                    Quantisation::range(
+                      _reradiation.data(),
+                      _reradiation.size(),
+                      reradiationScale,
+                      reradiationOffset);
+
+                    exrHeader.insert(
+                      RERADIATION_QUANTISATION_ATTR,
+                      Imf::FloatVectorAttribute(std::vector<float>(
+                        {reradiationScale, reradiationOffset})));
+                }
+
                 // Write the reradiation
                 const size_t xStrideReradiation
                   = sizeof(float) * reradiationSize();
@@ -518,16 +477,14 @@ namespace SEXR
                       _wavelengths_nm[wlFromIdx],
                       _wavelengths_nm[wlToIdx]);
 
-                    exrChannels.insert(channelName, Imf::Channel(compType));
-
-                    char *framebuffer = (char *)(&_reradiation[rr]);
-                    exrFrameBuffer.insert(
+                    exrWriter.addChannel(
                       channelName,
-                      Imf::Slice(
-                        compType,
-                        framebuffer,
-                        xStrideReradiation,
-                        yStrideReradiation));
+                      &_reradiation[rr],
+                      xStrideReradiation,
+                      yStrideReradiation,
+                      options.reradiationType,
+                      reradiationScale,
+                      reradiationOffset);
                 }
             }
         }
@@ -582,9 +539,7 @@ namespace SEXR
               Imf::StringAttribute(handednessAtrrValue));
         }
 
-        Imf::OutputFile exrOut(filename.c_str(), exrHeader);
-        exrOut.setFrameBuffer(exrFrameBuffer);
-        exrOut.writePixels(height());
+        exrWriter.write(filename, options);
     }
 
     SpectrumType EXRBiSpectralImage::channelType(
@@ -593,110 +548,11 @@ namespace SEXR
       double &           wavelength_nm,
       double &           reradiation_wavelength_nm)
     {
-        const std::string exprRefl   = "T";
-        const std::string exprStokes = "S([0-3])";
-        const std::string exprPola  = "((" + exprStokes + ")|" + exprRefl + ")";
-        const std::string exprValue = "(\\d*,?\\d*([Ee][+-]?\\d+)?)";
-        const std::string exprUnits
-          = "(Y|Z|E|P|T|G|M|k|h|da|d|c|m|u|n|p)?(m|Hz)";
-
-        const std::regex exprDiagonal(
-          "^" + exprPola + "\\." + exprValue + exprUnits + "$");
-        const std::regex exprRerad(
-          "^" + exprRefl + "\\." + exprValue + exprUnits + "\\." + exprValue
-          + exprUnits + "$");
-
-        std::smatch matches;
-
-        const bool matchedDiagonal
-          = std::regex_search(channelName, matches, exprDiagonal);
-
-        if (matchedDiagonal) {
-            if (matches.size() != 8) {
-                // Something went wrong with the parsing. This shall not occur.
-                throw INTERNAL_ERROR;
-            }
-
-            SpectrumType type;
-
-            switch (matches[1].str()[0]) {
-                case 'S':
-                    type                  = SpectrumType::EMISSIVE;
-                    polarisationComponent = std::stoi(matches[3].str());
-                    if (polarisationComponent > 0) {
-                        type = type | SpectrumType::POLARISED;
-                    }
-                    break;
-
-                case 'T':
-                    type = SpectrumType::REFLECTIVE;
-                    break;
-
-                default:
-                    return SpectrumType::UNDEFINED;
-            }
-
-            // Get value illumination
-            std::string centralValueStr(matches[4].str());
-            std::replace(
-              centralValueStr.begin(),
-              centralValueStr.end(),
-              ',',
-              '.');
-            const double value = std::stod(centralValueStr);
-
-            wavelength_nm = Util::strToNanometers(
-              value,              // Comma separated floating point value
-              matches[6].str(),   // Unit multiplier
-              matches[7].str()    // Units
-            );
-
-            return type;
-        }
-
-        const bool matchedRerad
-          = std::regex_search(channelName, matches, exprRerad);
-
-        if (matchedRerad) {
-            if (matches.size() != 9) {
-                // Something went wrong with the parsing. This shall not occur.
-                throw INTERNAL_ERROR;
-            }
-
-            // Get value illumination
-            std::string centralValueStrI(matches[1].str());
-            std::replace(
-              centralValueStrI.begin(),
-              centralValueStrI.end(),
-              ',',
-              '.');
-            const float value_i = std::stof(centralValueStrI);
-
-            wavelength_nm = Util::strToNanometers(
-              value_i,
-              matches[3].str(),   // Unit multiplier
-              matches[4].str()    // Units
-            );
-
-            // Get value reradiation
-            std::string centralValueStrO(matches[5].str());
-            std::replace(
-              centralValueStrO.begin(),
-              centralValueStrO.end(),
-              ',',
-              '.');
-            const float value_o = std::stof(centralValueStrO);
-
-            reradiation_wavelength_nm = Util::strToNanometers(
-              value_o,
-              matches[7].str(),   // Unit multiplier
-              matches[8].str()    // Units
-            );
-
-            return SpectrumType::BISPECTRAL;
-        }
-
-        return SpectrumType::UNDEFINED;
+        return EXRChannelName::parse(
+          channelName,
+          polarisationComponent,
+          wavelength_nm,
+          reradiation_wavelength_nm);
     }
 
 
@@ -705,13 +561,8 @@ namespace SEXR
     {
         assert(stokesComponent < 4);
 
-        std::stringstream b;
-        std::string       wavelengthStr = std::to_string(wavelength_nm);
-        std::replace(wavelengthStr.begin(), wavelengthStr.end(), '.', ',');
-
-        b << "S" << stokesComponent << "." << wavelengthStr << "nm";
-
-        const std::string channelName = b.str();
+        const std::string channelName
+          = EXRChannelName::emissive(stokesComponent, wavelength_nm);
 
 #ifndef NDEBUG
         int          stokesComponentChecked;
@@ -735,14 +586,8 @@ namespace SEXR
     std::string
     EXRBiSpectralImage::getReflectiveChannelName(double wavelength_nm)
     {
-        std::stringstream b;
-        std::string       wavelengthStr = std::to_string(wavelength_nm);
-        std::replace(wavelengthStr.begin(), wavelengthStr.end(), '.', ',');
-
-        b << "T"
-          << "." << wavelengthStr << "nm";
-
-        const std::string channelName = b.str();
+        const std::string channelName
+          = EXRChannelName::reflective(wavelength_nm);
 
 #ifndef NDEBUG
         int          stokesComponent;
@@ -765,19 +610,9 @@ namespace SEXR
     std::string EXRBiSpectralImage::getReradiationChannelName(
       double wavelength_nm, double reradiation_wavelength_nm)
     {
-        std::string reradWavelengthStr
-          = std::to_string(reradiation_wavelength_nm);
-        std::replace(
-          reradWavelengthStr.begin(),
-          reradWavelengthStr.end(),
-          '.',
-          ',');
-
-        std::stringstream b;
-        b << getReflectiveChannelName(wavelength_nm) << '.'
-          << reradWavelengthStr << "nm";
-
-        const std::string channelName = b.str();
+        const std::string channelName = EXRChannelName::reradiation(
+          wavelength_nm,
+          reradiation_wavelength_nm);
 
 #ifndef NDEBUG
         int    stokesComponent;
@@ -0,0 +1,250 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "EXRChannelName.h"
+#include "Util.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace SEXR
+{
+    SpectrumType EXRChannelName::parse(
+      const std::string &channelName,
+      int &              polarisationComponent,
+      double &           wavelength_nm,
+      double &           reradiation_wavelength_nm)
+    {
+        const char *c   = channelName.c_str();
+        const char *end = c + channelName.size();
+
+        SpectrumType type;
+        int          stokesComponent = 0;
+
+        if (end - c >= 2 && c[0] == 'S' && c[1] >= '0' && c[1] <= '3') {
+            stokesComponent = c[1] - '0';
+            type            = SpectrumType::EMISSIVE;
+
+            if (stokesComponent > 0) {
+                type = type | SpectrumType::POLARISED;
+            }
+
+            c += 2;
+        } else if (end - c >= 1 && c[0] == 'T') {
+            type = SpectrumType::REFLECTIVE;
+            c += 1;
+        } else {
+            return SpectrumType::UNDEFINED;
+        }
+
+        Token in, out;
+
+        if (c == end || *c != '.' || !scan(c + 1, end, in)) {
+            return SpectrumType::UNDEFINED;
+        }
+
+        if (in.end == end) {
+            if (!toNanometers(in, false, wavelength_nm)) {
+                return SpectrumType::UNDEFINED;
+            }
+
+            if (isEmissiveSpectrum(type)) {
+                polarisationComponent = stokesComponent;
+            }
+
+            return type;
+        }
+
+        // Only reflective channels have a reradiation wavelength
+        if (
+          type != SpectrumType::REFLECTIVE || !scan(in.end + 1, end, out)
+          || out.end != end) {
+            return SpectrumType::UNDEFINED;
+        }
+
+        if (
+          !toNanometers(in, true, wavelength_nm)
+          || !toNanometers(out, true, reradiation_wavelength_nm)) {
+            return SpectrumType::UNDEFINED;
+        }
+
+        return SpectrumType::BISPECTRAL;
+    }
+
+
+    std::string
+    EXRChannelName::emissive(int stokesComponent, double wavelength_nm)
+    {
+        std::string name = "S0.";
+        name[1] += stokesComponent;
+
+        appendWavelength(name, wavelength_nm);
+
+        return name;
+    }
+
+
+    std::string EXRChannelName::reflective(double wavelength_nm)
+    {
+        std::string name = "T.";
+
+        appendWavelength(name, wavelength_nm);
+
+        return name;
+    }
+
+
+    std::string EXRChannelName::reradiation(
+      double wavelength_nm, double reradiation_wavelength_nm)
+    {
+        std::string name = "T.";
+
+        appendWavelength(name, wavelength_nm);
+        name += '.';
+        appendWavelength(name, reradiation_wavelength_nm);
+
+        return name;
+    }
+
+
+    bool EXRChannelName::scan(const char *begin, const char *end, Token &token)
+    {
+        const char *c = begin;
+
+        // Value: digits, an optional decimal comma, digits and an
+        // optional exponent
+        size_t nDigits = 0;
+
+        for (; c != end && *c >= '0' && *c <= '9'; c++) nDigits++;
+
+        if (c != end && *c == ',') c++;
+
+        for (; c != end && *c >= '0' && *c <= '9'; c++) nDigits++;
+
+        if (nDigits == 0) {
+            return false;
+        }
+
+        // An 'E' not followed by digits is the exa prefix
+        if (c != end && (*c == 'E' || *c == 'e')) {
+            const char *e = c + 1;
+
+            if (e != end && (*e == '+' || *e == '-')) e++;
+
+            if (e != end && *e >= '0' && *e <= '9') {
+                for (c = e; c != end && *c >= '0' && *c <= '9'; c++)
+                    ;
+            }
+        }
+
+        token.value  = begin;
+        token.prefix = c;
+
+        // Units: an optional SI prefix followed by m or Hz
+        const char *unitsEnd = c;
+
+        while (unitsEnd != end && *unitsEnd != '.') unitsEnd++;
+
+        if (unitsEnd - c >= 2 && unitsEnd[-2] == 'H' && unitsEnd[-1] == 'z') {
+            token.units = unitsEnd - 2;
+        } else if (unitsEnd - c >= 1 && unitsEnd[-1] == 'm') {
+            token.units = unitsEnd - 1;
+        } else {
+            return false;
+        }
+
+        token.end = unitsEnd;
+
+        return token.units == token.prefix
+               || Util::prefixMultiplier(
+                    token.prefix,
+                    token.units - token.prefix)
+                    != 0;
+    }
+
+
+    bool EXRChannelName::toNanometers(
+      const Token &token, bool singlePrecision, double &nm)
+    {
+        std::string valueStr(token.value, token.prefix);
+
+        for (char &c : valueStr) {
+            if (c == ',') c = '.';
+        }
+
+        errno = 0;
+
+        const double value = singlePrecision
+                               ? std::strtof(valueStr.c_str(), nullptr)
+                               : std::strtod(valueStr.c_str(), nullptr);
+
+        if (errno == ERANGE) {
+            return false;
+        }
+
+        try {
+            nm = Util::strToNanometers(
+              value,
+              std::string(token.prefix, token.units),
+              std::string(token.units, token.end));
+        } catch (std::out_of_range &exception) {
+            return false;
+        }
+
+        return true;
+    }
+
+
+    void
+    EXRChannelName::appendWavelength(std::string &name, double wavelength_nm)
+    {
+        // Same formatting as std::to_string() with a decimal comma.
+        // The buffer holds the largest double printed with %f
+        char      buffer[400];
+        const int n
+          = std::snprintf(buffer, sizeof(buffer), "%f", wavelength_nm);
+
+        for (int i = 0; i < n; i++) {
+            if (buffer[i] == '.') buffer[i] = ',';
+        }
+
+        name.append(buffer, n);
+        name += "nm";
+    }
+
+}   // namespace SEXR
@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <SpectrumType.h>
+
+namespace SEXR
+{
+    /**
+     * Parses and formats the names of the spectral channels:
+     * S<n>.<value><unit> for the emissive channels, T.<value><unit>
+     * for the reflective ones and T.<value><unit>.<value><unit> for
+     * the reradiation. Values use a comma as decimal separator and
+     * units are m or Hz with an optional SI prefix.
+     *
+     * The names are scanned by hand so that classifying the few
+     * thousands channels of a bispectral file does not compile any
+     * regular expression nor allocate beyond the short value
+     * strings.
+     */
+    class EXRChannelName
+    {
+      public:
+        /**
+         * Gets the type of a channel from its name.
+         *
+         * @param channelName name of the channel.
+         * @param polarisationComponent set to the Stokes component of
+         * an emissive channel.
+         * @param wavelength_nm set to the wavelength of a spectral
+         * channel or the illumination wavelength of a reradiation.
+         * @param reradiation_wavelength_nm set to the reemission
+         * wavelength of a reradiation channel.
+         *
+         * @returns the type of the channel, BISPECTRAL for a
+         * reradiation and UNDEFINED for a non spectral channel.
+         */
+        static SpectrumType parse(
+          const std::string &channelName,
+          int &              polarisationComponent,
+          double &           wavelength_nm,
+          double &           reradiation_wavelength_nm);
+
+        static std::string emissive(int stokesComponent, double wavelength_nm);
+
+        static std::string reflective(double wavelength_nm);
+
+        static std::string
+        reradiation(double wavelength_nm, double reradiation_wavelength_nm);
+
+      protected:
+        /** Parts of a <value><unit> token. */
+        struct Token
+        {
+            const char *value, *prefix, *units, *end;
+        };
+
+        /**
+         * Scans a <value><unit> token from begin up to the next '.' or
+         * the end of the name.
+         *
+         * @returns false if the characters do not form a token.
+         */
+        static bool scan(const char *begin, const char *end, Token &token);
+
+        /**
+         * Converts a token to nanometers. The value is read with
+         * single precision for reradiation channels, as the loaders
+         * always did.
+         *
+         * @returns false if the value cannot be represented.
+         */
+        static bool
+        toNanometers(const Token &token, bool singlePrecision, double &nm);
+
+        static void appendWavelength(std::string &name, double wavelength_nm);
+    };
+
+}   // namespace SEXR
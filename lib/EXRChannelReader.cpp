@@ -0,0 +1,872 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "EXRChannelReader.h"
+#include "EXRChannelName.h"
+#include "HalfConversion.h"
+#include "PlanarStaging.h"
+#include "Quantisation.h"
+
+#include <EXRBiSpectralImage.h>
+#include <SpectralImage.h>
+#include <Threading.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <OpenEXR/ImfChannelList.h>
+#include <OpenEXR/ImfFloatVectorAttribute.h>
+#include <OpenEXR/ImfFrameBuffer.h>
+#include <OpenEXR/ImfHeader.h>
+
+namespace SEXR
+{
+    EXRChannelReader::EXRChannelReader(
+      const std::string &filename, int nThreads)
+      : _file(new Imf::MultiPartInputFile(
+        filename.c_str(),
+        nThreads < 0 ? Threading::openEXRThreadCount() : nThreads))
+      , _level(0)
+      , _transfer(PlanarStaging::AUTOMATIC)
+    {
+        const int nParts = _file->parts();
+
+        _scanlineParts.resize(nParts);
+        _tiledParts.resize(nParts);
+        _targets.resize(nParts);
+
+        // The first part holds the attributes, the channels of all the
+        // parts are listed together
+        _header = _file->header(0);
+
+        for (int p = 1; p < nParts; p++) {
+            const Imf::ChannelList &channels = _file->header(p).channels();
+
+            for (Imf::ChannelList::ConstIterator channel = channels.begin();
+                 channel != channels.end();
+                 channel++) {
+                if (_header.channels().findChannel(channel.name()) == nullptr) {
+                    _header.channels().insert(
+                      channel.name(),
+                      channel.channel());
+                }
+            }
+        }
+
+        _region = _header.dataWindow();
+    }
+
+
+    const Imf::Header &EXRChannelReader::header() const { return _header; }
+
+
+    bool EXRChannelReader::isTiled(int part) const
+    {
+        return _file->header(part).hasTileDescription();
+    }
+
+
+    Imf::InputPart &EXRChannelReader::scanlinePart(int part)
+    {
+        if (!_scanlineParts[part]) {
+            _scanlineParts[part].reset(new Imf::InputPart(*_file, part));
+        }
+
+        return *_scanlineParts[part];
+    }
+
+
+    Imf::TiledInputPart &EXRChannelReader::tiledPart(int part)
+    {
+        if (!_tiledParts[part]) {
+            _tiledParts[part].reset(new Imf::TiledInputPart(*_file, part));
+        }
+
+        return *_tiledParts[part];
+    }
+
+
+    void EXRChannelReader::setLevel(size_t level)
+    {
+        const int l = int(level);
+
+        for (int p = 0; p < _file->parts() && l > 0; p++) {
+            if (!isTiled(p) || !tiledPart(p).isValidLevel(l, l)) {
+                throw SpectralImage::INVALID_OPTIONS;
+            }
+        }
+
+        _level  = l;
+        _region = dataWindow();
+    }
+
+
+    size_t EXRChannelReader::nLevels() const
+    {
+        const Imath::Box2i &dataWindow = _header.dataWindow();
+
+        const size_t width  = dataWindow.max.x - dataWindow.min.x + 1;
+        const size_t height = dataWindow.max.y - dataWindow.min.y + 1;
+
+        size_t nLevels = SIZE_MAX;
+
+        for (int p = 0; p < _file->parts(); p++) {
+            const Imf::Header &exrHeader = _file->header(p);
+
+            if (
+              !exrHeader.hasTileDescription()
+              || exrHeader.tileDescription().mode == Imf::ONE_LEVEL) {
+                return 1;
+            }
+
+            // Same level count as OpenEXR. Levels loaded by index exist
+            // along both axes, which limits ripmaps to the smallest side
+            const Imf::TileDescription &tiles = exrHeader.tileDescription();
+
+            const size_t size = tiles.mode == Imf::MIPMAP_LEVELS
+                                  ? std::max(width, height)
+                                  : std::min(width, height);
+            size_t log2 = 0;
+
+            while ((size_t(1) << (log2 + 1)) <= size) {
+                log2++;
+            }
+
+            if (
+              tiles.roundingMode == Imf::ROUND_UP
+              && (size_t(1) << log2) < size) {
+                log2++;
+            }
+
+            nLevels = std::min(nLevels, log2 + 1);
+        }
+
+        return nLevels;
+    }
+
+
+    Imath::Box2i EXRChannelReader::dataWindow()
+    {
+        return _level > 0 ? tiledPart(0).dataWindowForLevel(_level)
+                          : _header.dataWindow();
+    }
+
+
+    void EXRChannelReader::addChannel(
+      const std::string &name,
+      float *            base,
+      size_t             xStride,
+      size_t             yStride,
+      float              scale,
+      float              offset)
+    {
+        // Missing channels are filled by the library as FLOAT
+        Imf::PixelType type = Imf::FLOAT;
+        int            part = 0;
+
+        for (int p = 0; p < _file->parts(); p++) {
+            const Imf::Channel *channel
+              = _file->header(p).channels().findChannel(name);
+
+            if (channel != nullptr) {
+                type = channel->type;
+                part = p;
+                break;
+            }
+        }
+
+        Target target
+          = {name, (char *)base, xStride, yStride, type, scale, offset};
+        _targets[part].push_back(target);
+    }
+
+
+    void EXRChannelReader::clearChannels()
+    {
+        for (std::vector<Target> &targets : _targets) {
+            targets.clear();
+        }
+    }
+
+
+    bool EXRChannelReader::needsStaging(int part) const
+    {
+        for (const Target &t : _targets[part]) {
+            if (
+              t.type != Imf::FLOAT || t.scale != 1.F || t.offset != 0.F
+              || PlanarStaging::isStaged(_transfer, t.xStride)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+
+    EXRChannelReader::Staging
+    EXRChannelReader::staging(int part, size_t nPixels) const
+    {
+        const std::vector<Target> &targets = _targets[part];
+
+        Staging staging;
+
+        for (const Target &t : targets) {
+            switch (t.type) {
+                case Imf::HALF:
+                    staging.halfValues.resize(targets.size() * nPixels);
+                    break;
+                case Imf::UINT:
+                    staging.uintValues.resize(targets.size() * nPixels);
+                    break;
+                default:
+                    staging.floatValues.resize(targets.size() * nPixels);
+                    break;
+            }
+        }
+
+        return staging;
+    }
+
+
+    void EXRChannelReader::read()
+    {
+        // Parts without requested channels are never opened
+        for (int p = 0; p < _file->parts(); p++) {
+            if (_targets[p].empty()) {
+                continue;
+            }
+
+            if (isTiled(p)) {
+                readTiles(p);
+            } else {
+                readScanlines(p);
+            }
+        }
+    }
+
+
+    void EXRChannelReader::readScanlines(int part)
+    {
+        Imf::InputPart &    exrPart    = scanlinePart(part);
+        const Imath::Box2i &dataWindow = exrPart.header().dataWindow();
+
+        // Full width FLOAT channels: the file can be read in place
+        if (
+          _region.min.x == dataWindow.min.x && _region.max.x == dataWindow.max.x
+          && !needsStaging(part)) {
+            exrPart.setFrameBuffer(frameBuffer(part));
+            exrPart.readPixels(_region.min.y, _region.max.y);
+
+            return;
+        }
+
+        // Otherwise, scanlines are decoded whole by the library: read
+        // them by chunks of compression blocks in a staging buffer,
+        // then convert and keep the columns of the region
+        const size_t fileWidth = dataWindow.max.x - dataWindow.min.x + 1;
+
+        const int blockLines
+          = PlanarStaging::linesPerBlock(exrPart.header().compression());
+        const int chunkLines = PlanarStaging::chunkLines(
+          blockLines,
+          _targets[part].size() * fileWidth * sizeof(float));
+
+        Staging chunkStaging = staging(part, fileWidth * chunkLines);
+
+        int y0 = _region.min.y;
+
+        while (y0 <= _region.max.y) {
+            // Ends the chunk on a block boundary
+            const int blockStart = y0 - (y0 - dataWindow.min.y) % blockLines;
+            const int y1 = std::min(blockStart + chunkLines - 1, _region.max.y);
+
+            const Imath::Box2i chunk(
+              Imath::V2i(dataWindow.min.x, y0),
+              Imath::V2i(dataWindow.max.x, y1));
+
+            exrPart.setFrameBuffer(frameBuffer(part, chunkStaging, chunk));
+            exrPart.readPixels(y0, y1);
+
+            copyFromStaging(part, chunkStaging, chunk);
+
+            y0 = y1 + 1;
+        }
+    }
+
+
+    void EXRChannelReader::readTiles(int part)
+    {
+        Imf::TiledInputPart &exrPart    = tiledPart(part);
+        const Imath::Box2i   dataWindow = exrPart.dataWindowForLevel(_level);
+
+        const int tileWidth  = exrPart.tileXSize();
+        const int tileHeight = exrPart.tileYSize();
+
+        // Tiles overlapping the region
+        const int dx1 = (_region.min.x - dataWindow.min.x) / tileWidth;
+        const int dx2 = (_region.max.x - dataWindow.min.x) / tileWidth;
+        const int dy1 = (_region.min.y - dataWindow.min.y) / tileHeight;
+        const int dy2 = (_region.max.y - dataWindow.min.y) / tileHeight;
+
+        // Whole image of FLOAT channels: the tiles can be read in place
+        if (
+          _region.min.x == dataWindow.min.x && _region.min.y == dataWindow.min.y
+          && _region.max.x == dataWindow.max.x
+          && _region.max.y == dataWindow.max.y && !needsStaging(part)) {
+            exrPart.setFrameBuffer(frameBuffer(part));
+            exrPart.readTiles(dx1, dx2, dy1, dy2, _level);
+
+            return;
+        }
+
+        // Otherwise, read them by rows of tiles in a staging buffer,
+        // then convert and keep the pixels of the region
+        const int rowWidth
+          = exrPart.dataWindowForTile(dx2, dy1, _level).max.x
+            - exrPart.dataWindowForTile(dx1, dy1, _level).min.x + 1;
+
+        Staging rowStaging = staging(part, rowWidth * tileHeight);
+
+        for (int dy = dy1; dy <= dy2; dy++) {
+            const Imath::Box2i row(
+              exrPart.dataWindowForTile(dx1, dy, _level).min,
+              exrPart.dataWindowForTile(dx2, dy, _level).max);
+
+            exrPart.setFrameBuffer(frameBuffer(part, rowStaging, row));
+            exrPart.readTiles(dx1, dx2, dy, dy, _level);
+
+            copyFromStaging(part, rowStaging, row);
+        }
+    }
+
+
+    const float *EXRChannelReader::convert(
+      const Target & t,
+      const Staging &staging,
+      size_t         i,
+      size_t         n,
+      float *        converted)
+    {
+        if (t.type == Imf::HALF) {
+            HalfConversion::toFloat(
+              &staging.halfValues[i],
+              n,
+              t.scale,
+              converted);
+
+            if (t.offset != 0.F) {
+                for (size_t x = 0; x < n; x++) {
+                    converted[x] += t.offset;
+                }
+            }
+        } else if (t.type == Imf::UINT) {
+            Quantisation::dequantise(
+              &staging.uintValues[i],
+              n,
+              t.scale,
+              t.offset,
+              converted);
+        } else if (t.scale != 1.F || t.offset != 0.F) {
+            for (size_t x = 0; x < n; x++) {
+                converted[x] = t.offset + staging.floatValues[i + x] * t.scale;
+            }
+        } else {
+            return &staging.floatValues[i];
+        }
+
+        return converted;
+    }
+
+
+    void EXRChannelReader::copyFromStaging(
+      int part, const Staging &staging, const Imath::Box2i &box)
+    {
+        const std::vector<Target> &targets = _targets[part];
+
+        const size_t boxWidth  = box.max.x - box.min.x + 1;
+        const size_t boxPixels = boxWidth * (box.max.y - box.min.y + 1);
+
+        const int x0 = std::max(box.min.x, _region.min.x);
+        const int x1 = std::min(box.max.x, _region.max.x);
+        const int y0 = std::max(box.min.y, _region.min.y);
+        const int y1 = std::min(box.max.y, _region.max.y);
+
+        const size_t n = x1 - x0 + 1;
+
+        // Channels interleaved in the same buffer are transposed
+        // together, the others are runs of a single channel
+        const std::vector<std::vector<size_t>> runs
+          = PlanarStaging::runs(targets, [](const Target &) { return true; });
+
+        const int nThreads = static_cast<int>(Threading::threadCount());
+
+#pragma omp parallel num_threads(nThreads)
+        {
+            std::vector<float>         converted;
+            std::vector<const float *> planes;
+
+#pragma omp for schedule(dynamic)
+            for (int y = y0; y <= y1; y++) {
+                for (const std::vector<size_t> &run : runs) {
+                    converted.resize(run.size() * n);
+                    planes.resize(run.size());
+
+                    for (size_t k = 0; k < run.size(); k++) {
+                        const size_t i = run[k] * boxPixels
+                                         + (y - box.min.y) * boxWidth + x0
+                                         - box.min.x;
+
+                        planes[k] = convert(
+                          targets[run[k]],
+                          staging,
+                          i,
+                          n,
+                          &converted[k * n]);
+                    }
+
+                    const Target &t = targets[run.front()];
+
+                    char *dst = t.base + (y - _region.min.y) * t.yStride
+                                + (x0 - _region.min.x) * t.xStride;
+
+                    PlanarStaging::toInterleaved(
+                      planes.data(),
+                      run.size(),
+                      n,
+                      (float *)dst,
+                      t.xStride / sizeof(float));
+                }
+            }
+        }
+    }
+
+
+    Imf::FrameBuffer EXRChannelReader::frameBuffer(int part) const
+    {
+        Imf::FrameBuffer exrFrameBuffer;
+
+        for (const Target &t : _targets[part]) {
+            exrFrameBuffer.insert(
+              t.name,
+              Imf::Slice::Make(
+                Imf::FLOAT,
+                t.base,
+                _region,
+                t.xStride,
+                t.yStride));
+        }
+
+        return exrFrameBuffer;
+    }
+
+
+    Imf::FrameBuffer EXRChannelReader::frameBuffer(
+      int part, Staging &staging, const Imath::Box2i &box) const
+    {
+        const std::vector<Target> &targets = _targets[part];
+
+        const size_t boxWidth  = box.max.x - box.min.x + 1;
+        const size_t boxPixels = boxWidth * (box.max.y - box.min.y + 1);
+
+        Imf::FrameBuffer exrFrameBuffer;
+
+        for (size_t c = 0; c < targets.size(); c++) {
+            const Target &t = targets[c];
+
+            switch (t.type) {
+                case Imf::HALF:
+                    exrFrameBuffer.insert(
+                      t.name,
+                      Imf::Slice::Make(
+                        Imf::HALF,
+                        &staging.halfValues[c * boxPixels],
+                        box,
+                        sizeof(uint16_t),
+                        sizeof(uint16_t) * boxWidth));
+                    break;
+
+                case Imf::UINT:
+                    exrFrameBuffer.insert(
+                      t.name,
+                      Imf::Slice::Make(
+                        Imf::UINT,
+                        &staging.uintValues[c * boxPixels],
+                        box,
+                        sizeof(uint32_t),
+                        sizeof(uint32_t) * boxWidth));
+                    break;
+
+                default:
+                    exrFrameBuffer.insert(
+                      t.name,
+                      Imf::Slice::Make(
+                        Imf::FLOAT,
+                        &staging.floatValues[c * boxPixels],
+                        box,
+                        sizeof(float),
+                        sizeof(float) * boxWidth));
+                    break;
+            }
+        }
+
+        return exrFrameBuffer;
+    }
+
+
+    Imath::Box2i EXRChannelReader::loadRegion(
+      const Imath::Box2i &dataWindow, const LoadOptions &options)
+    {
+        if (!options.hasRegion) {
+            return dataWindow;
+        }
+
+        const size_t width  = dataWindow.max.x - dataWindow.min.x + 1;
+        const size_t height = dataWindow.max.y - dataWindow.min.y + 1;
+
+        if (
+          options.regionWidth == 0 || options.regionHeight == 0
+          || options.regionX + options.regionWidth > width
+          || options.regionY + options.regionHeight > height) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        const Imath::V2i min(
+          dataWindow.min.x + int(options.regionX),
+          dataWindow.min.y + int(options.regionY));
+
+        const Imath::V2i max(
+          min.x + int(options.regionWidth) - 1,
+          min.y + int(options.regionHeight) - 1);
+
+        return Imath::Box2i(min, max);
+    }
+
+
+    std::vector<size_t> EXRChannelReader::loadBands(
+      const std::vector<float> &wavelengths_nm, const LoadOptions &options)
+    {
+        std::vector<size_t> listed;
+
+        if (!options.wavelengthList_nm.empty()) {
+            for (float requested_nm : options.wavelengthList_nm) {
+                // Tolerates the rounding of the wavelengths written in
+                // channel names
+                size_t b = 0;
+
+                while (
+                  b < wavelengths_nm.size()
+                  && std::abs(wavelengths_nm[b] - requested_nm) > 1e-2F) {
+                    b++;
+                }
+
+                if (b == wavelengths_nm.size()) {
+                    throw SpectralImage::INVALID_OPTIONS;
+                }
+
+                listed.push_back(b);
+            }
+
+            // Bands stay sorted by wavelength
+            std::sort(listed.begin(), listed.end());
+            listed.erase(
+              std::unique(listed.begin(), listed.end()),
+              listed.end());
+        } else {
+            for (size_t b = 0; b < wavelengths_nm.size(); b++) {
+                listed.push_back(b);
+            }
+        }
+
+        // Both restrictions apply when both are set
+        std::vector<size_t> bands;
+
+        for (size_t b : listed) {
+            if (
+              !options.hasWavelengthRange
+              || (wavelengths_nm[b] >= options.minWavelength_nm
+                  && wavelengths_nm[b] <= options.maxWavelength_nm)) {
+                bands.push_back(b);
+            }
+        }
+
+        if (bands.empty()) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        return bands;
+    }
+
+
+    SpectrumType EXRChannelReader::loadComponents(
+      SpectrumType fileType, const LoadOptions &options)
+    {
+        SpectrumType type
+          = static_cast<SpectrumType>(fileType & options.components);
+
+        // The polarisation is only stored with the emissive part
+        if (!isEmissiveSpectrum(type)) {
+            type = static_cast<SpectrumType>(type & ~POLARISED);
+        }
+
+        if (type == SpectrumType::UNDEFINED) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        return type;
+    }
+
+
+    void EXRChannelReader::readQuantisation(
+      const Imf::Header &header,
+      const char *       name,
+      float &            scale,
+      float &            offset)
+    {
+        const Imf::FloatVectorAttribute *attr
+          = header.findTypedAttribute<Imf::FloatVectorAttribute>(name);
+
+        if (attr == nullptr) {
+            return;
+        }
+
+        const std::vector<float> &values = attr->value();
+
+        if (
+          values.size() != 2 || !std::isfinite(values[0])
+          || !std::isfinite(values[1])) {
+            throw SpectralImage::INCORRECT_FORMED_FILE;
+        }
+
+        scale  = values[0];
+        offset = values[1];
+    }
+
+
+    EXRChannelReader::SpectralChannels EXRChannelReader::spectralChannels(
+      const Imf::Header &header, bool bispectral, const LoadOptions &options)
+    {
+        SpectralChannels channels;
+
+        // ---------------------------------------------------------------------
+        // Classify the channels
+        // ---------------------------------------------------------------------
+
+        const Imf::ChannelList &exrChannels = header.channels();
+
+        SpectrumType fileType = SpectrumType::UNDEFINED;
+
+        for (Imf::ChannelList::ConstIterator channel = exrChannels.begin();
+             channel != exrChannels.end();
+             channel++) {
+            int    polarisationComponent;
+            double in_wavelength_nm, out_wavelength_nm;
+
+            const SpectrumType channelType = EXRChannelName::parse(
+              channel.name(),
+              polarisationComponent,
+              in_wavelength_nm,
+              out_wavelength_nm);
+
+            if (
+              channelType == SpectrumType::UNDEFINED
+              || (isBispectralSpectrum(channelType) && !bispectral)) {
+                continue;
+            }
+
+            fileType = fileType | channelType;
+
+            if (isBispectralSpectrum(channelType)) {
+                channels.reradiation.push_back(std::make_pair(
+                  std::make_pair(in_wavelength_nm, out_wavelength_nm),
+                  channel.name()));
+            } else if (isReflectiveSpectrum(channelType)) {
+                channels.reflective.push_back(
+                  std::make_pair(in_wavelength_nm, channel.name()));
+            } else {
+                channels.emissive[polarisationComponent].push_back(
+                  std::make_pair(in_wavelength_nm, channel.name()));
+            }
+        }
+
+        if (fileType == SpectrumType::UNDEFINED) {
+            // Probably an RGB EXR, not our job to handle it
+            throw SpectralImage::INCORRECT_FORMED_FILE;
+        }
+
+        // Sort by ascending wavelengths, the reradiation by input then
+        // output wavelength
+        for (auto &stokes : channels.emissive) {
+            std::sort(stokes.begin(), stokes.end());
+        }
+
+        std::sort(channels.reflective.begin(), channels.reflective.end());
+        std::sort(channels.reradiation.begin(), channels.reradiation.end());
+
+        // ---------------------------------------------------------------------
+        // Sanity check
+        // ---------------------------------------------------------------------
+
+        // Every component must have the same wavelengths
+        const std::vector<std::pair<float, std::string>> &reference
+          = isEmissiveSpectrum(fileType) ? channels.emissive[0]
+                                         : channels.reflective;
+
+        auto sameWavelengths =
+          [&reference](const std::vector<std::pair<float, std::string>> &l) {
+              if (l.size() != reference.size()) {
+                  return false;
+              }
+
+              for (size_t wl_idx = 0; wl_idx < l.size(); wl_idx++) {
+                  if (l[wl_idx].first != reference[wl_idx].first) {
+                      return false;
+                  }
+              }
+
+              return true;
+          };
+
+        const size_t nStokesComponents = isPolarisedSpectrum(fileType) ? 4 : 1;
+
+        for (size_t s = 1; s < nStokesComponents; s++) {
+            if (!sameWavelengths(channels.emissive[s])) {
+                throw SpectralImage::INCORRECT_FORMED_FILE;
+            }
+        }
+
+        if (
+          isEmissiveSpectrum(fileType) && isReflectiveSpectrum(fileType)
+          && !sameWavelengths(channels.reflective)) {
+            throw SpectralImage::INCORRECT_FORMED_FILE;
+        }
+
+        for (const auto &wl_index : reference) {
+            channels.wavelengths_nm.push_back(wl_index.first);
+        }
+
+        // ---------------------------------------------------------------------
+        // Select what to load
+        // ---------------------------------------------------------------------
+
+        channels.type = loadComponents(fileType, options);
+
+        // Emissive bands may be stored divided by a scale
+        channels.emissiveScales.assign(channels.wavelengths_nm.size(), 1.F);
+
+        const Imf::FloatVectorAttribute *emissiveScaleAttr
+          = header.findTypedAttribute<Imf::FloatVectorAttribute>(
+            EXRBiSpectralImage::EMISSIVE_SCALE_ATTR);
+
+        if (isEmissiveSpectrum(channels.type) && emissiveScaleAttr != nullptr) {
+            if (
+              emissiveScaleAttr->value().size()
+              != channels.emissiveScales.size()) {
+                throw SpectralImage::INCORRECT_FORMED_FILE;
+            }
+
+            channels.emissiveScales = emissiveScaleAttr->value();
+        }
+
+        // Reflective values may be quantised
+        channels.reflectiveScale  = 1.F;
+        channels.reflectiveOffset = 0.F;
+
+        if (isReflectiveSpectrum(channels.type)) {
+            readQuantisation(
+              header,
+              EXRBiSpectralImage::REFLECTIVE_QUANTISATION_ATTR,
+              channels.reflectiveScale,
+              channels.reflectiveOffset);
+        }
+
+        channels.reradiationScale  = 1.F;
+        channels.reradiationOffset = 0.F;
+
+        if (isBispectralSpectrum(channels.type)) {
+            readQuantisation(
+              header,
+              EXRBiSpectralImage::RERADIATION_QUANTISATION_ATTR,
+              channels.reradiationScale,
+              channels.reradiationOffset);
+        }
+
+        // Keep only the requested bands
+        const std::vector<size_t> bands
+          = loadBands(channels.wavelengths_nm, options);
+
+        if (bands.size() != channels.wavelengths_nm.size()) {
+            channels.wavelengths_nm = keepBands(channels.wavelengths_nm, bands);
+            channels.emissiveScales = keepBands(channels.emissiveScales, bands);
+
+            for (auto &stokes : channels.emissive) {
+                if (!stokes.empty()) {
+                    stokes = keepBands(stokes, bands);
+                }
+            }
+
+            if (!channels.reflective.empty()) {
+                channels.reflective = keepBands(channels.reflective, bands);
+            }
+
+            // Reradiation between two kept bands only
+            const std::vector<float> &kept = channels.wavelengths_nm;
+
+            std::vector<std::pair<std::pair<float, float>, std::string>>
+              keptReradiation;
+
+            for (const auto &rerad : channels.reradiation) {
+                const bool keptFrom = std::binary_search(
+                  kept.begin(),
+                  kept.end(),
+                  rerad.first.first);
+                const bool keptTo = std::binary_search(
+                  kept.begin(),
+                  kept.end(),
+                  rerad.first.second);
+
+                if (keptFrom && keptTo) {
+                    keptReradiation.push_back(rerad);
+                }
+            }
+
+            channels.reradiation = keptReradiation;
+        }
+
+        return channels;
+    }
+
+}   // namespace SEXR
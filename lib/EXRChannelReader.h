@@ -0,0 +1,372 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <OpenEXR/ImfHeader.h>
+#include <OpenEXR/ImfInputPart.h>
+#include <OpenEXR/ImfMultiPartInputFile.h>
+#include <OpenEXR/ImfTiledInputPart.h>
+
+#include <LoadOptions.h>
+
+#include "PlanarStaging.h"
+
+namespace SEXR
+{
+    /**
+     * Reads channels of a rectangle of a scanline or tiled EXR file as
+     * floats into arbitrary strided buffers. The channels can be
+     * spread over several parts: only the parts holding added
+     * channels are read, and single part files are read alike.
+     *
+     * When the rectangle does not match the scanlines or tiles of the
+     * file, when the values need a conversion, or when the pixels are
+     * too wide for the library to scatter the values efficiently, they
+     * are read by chunks aligned on the compression blocks or on the
+     * tiles in planar staging buffers, so the memory used is the
+     * rectangle plus a few scanlines or a row of tiles of the file.
+     */
+    class EXRChannelReader
+    {
+      public:
+        /**
+         * Opens a file and reads its header. The whole data window of
+         * the file is read unless a region is set.
+         *
+         * @param filename path to the file.
+         * @param nThreads number of threads decoding the chunks of the
+         * file, Threading::openEXRThreadCount() when negative.
+         */
+        EXRChannelReader(const std::string &filename, int nThreads = -1);
+
+        /**
+         * Header of the first part, listing the channels of all the
+         * parts.
+         */
+        const Imf::Header &header() const;
+
+        /** Whether a part of the file is stored as tiles. */
+        bool isTiled(int part = 0) const;
+
+        /**
+         * Selects the mipmap level to read. The region is reset to
+         * the data window of the level.
+         *
+         * @param level level to read, 0 being the full resolution.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if a part of the file
+         * has no such level.
+         */
+        void setLevel(size_t level);
+
+        /**
+         * Number of mipmap levels that can be read, the smallest among
+         * the parts. Levels exist along both axes, which limits ripmaps
+         * to the smallest side.
+         */
+        size_t nLevels() const;
+
+        /** Data window of the level to read. */
+        Imath::Box2i dataWindow();
+
+        /**
+         * Sets the rectangle to read.
+         *
+         * @param region rectangle to read, in the coordinates of the
+         * data window of the level.
+         */
+        void setRegion(const Imath::Box2i &region) { _region = region; }
+
+        /**
+         * Adds a channel to read. The value of the pixel x, y of the
+         * region is stored at base + y * yStride + x * xStride.
+         *
+         * @param name name of the channel in the file.
+         * @param base address of the value of the top left pixel.
+         * @param xStride offset in bytes between two columns, a
+         * multiple of sizeof(float).
+         * @param yStride offset in bytes between two rows.
+         * @param scale the values are read as offset + scale * v,
+         * where v is the value of the file, or its quantisation level
+         * for UINT channels.
+         * @param offset see scale.
+         */
+        void addChannel(
+          const std::string &name,
+          float *            base,
+          size_t             xStride,
+          size_t             yStride,
+          float              scale  = 1.F,
+          float              offset = 0.F);
+
+        /**
+         * Sets how the values are handed to OpenEXR. By default,
+         * channels interleaved with a stride wider than a cache line
+         * are decoded in planar staging buffers, then transposed.
+         */
+        void setTransfer(PlanarStaging::Transfer transfer)
+        {
+            _transfer = transfer;
+        }
+
+        /**
+         * Removes the added channels, to read other rectangles of the
+         * file in other buffers.
+         */
+        void clearChannels();
+
+        /** Reads all the added channels. */
+        void read();
+
+        /**
+         * Gets the rectangle of the file to load.
+         *
+         * @param dataWindow data window of the file.
+         * @param options options restricting the loading.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if the region of the
+         * options is empty or does not fit in the data window.
+         */
+        static Imath::Box2i
+        loadRegion(const Imath::Box2i &dataWindow, const LoadOptions &options);
+
+        /**
+         * Gets the indices of the spectral bands to load.
+         *
+         * @param wavelengths_nm sorted wavelengths of the file.
+         * @param options options restricting the loading.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if no band is
+         * selected or if a requested wavelength is not in the file.
+         */
+        static std::vector<size_t> loadBands(
+          const std::vector<float> &wavelengths_nm,
+          const LoadOptions &       options);
+
+        /**
+         * Gets the components of the file to load.
+         *
+         * @param fileType components present in the file.
+         * @param options options restricting the loading.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if none of the
+         * components of the file is selected.
+         */
+        static SpectrumType
+        loadComponents(SpectrumType fileType, const LoadOptions &options);
+
+        /**
+         * Reads the scale and the offset of quantised channels from an
+         * attribute holding both. They are left unchanged when the
+         * attribute is missing.
+         *
+         * @param header header of the file.
+         * @param name name of the attribute.
+         * @param scale receives the size of a quantisation step.
+         * @param offset receives the value of the level 0.
+         *
+         * @throws SpectralImage::INCORRECT_FORMED_FILE if the attribute
+         * is malformed.
+         */
+        static void readQuantisation(
+          const Imf::Header &header,
+          const char *       name,
+          float &            scale,
+          float &            offset);
+
+        /**
+         * Spectral channels of a file to load, see spectralChannels().
+         * The channel lists hold the bands to load, sorted by
+         * wavelength. The lists of the components present in the file
+         * are filled even when the components are not loaded.
+         */
+        struct SpectralChannels
+        {
+            /** Components to load. */
+            SpectrumType type;
+
+            /** Sorted wavelengths of the bands to load. */
+            std::vector<float> wavelengths_nm;
+
+            /** Emissive channels of each Stokes component. */
+            std::array<std::vector<std::pair<float, std::string>>, 4>
+              emissive;
+
+            /** Reflective channels, the diagonal of bispectral files. */
+            std::vector<std::pair<float, std::string>> reflective;
+
+            /**
+             * Reradiation channels, sorted by input then output
+             * wavelength. Empty unless bispectral channels are kept.
+             */
+            std::vector<std::pair<std::pair<float, float>, std::string>>
+              reradiation;
+
+            /** Scale of each emissive band, see addChannel(). */
+            std::vector<float> emissiveScales;
+
+            float reflectiveScale, reflectiveOffset;
+            float reradiationScale, reradiationOffset;
+        };
+
+        /**
+         * Classifies the spectral channels of a file and selects the
+         * ones to load. Every Stokes component and the reflective
+         * part must have the same wavelengths.
+         *
+         * @param header header listing the channels of the file.
+         * @param bispectral whether the reradiation channels are kept,
+         * otherwise they are ignored.
+         * @param options options restricting the loading.
+         *
+         * @throws SpectralImage::INCORRECT_FORMED_FILE if the file has
+         * no spectral channel, inconsistent wavelengths or malformed
+         * scaling attributes.
+         * @throws SpectralImage::INVALID_OPTIONS if the options do not
+         * match the file.
+         */
+        static SpectralChannels spectralChannels(
+          const Imf::Header &header,
+          bool               bispectral,
+          const LoadOptions &options);
+
+        /** Keeps the elements of a per band list for the given bands. */
+        template<typename T>
+        static std::vector<T> keepBands(
+          const std::vector<T> &values, const std::vector<size_t> &bands)
+        {
+            std::vector<T> kept;
+            kept.reserve(bands.size());
+
+            for (size_t b : bands) {
+                kept.push_back(values[b]);
+            }
+
+            return kept;
+        }
+
+      private:
+        struct Target
+        {
+            std::string name;
+            char *      base;
+            size_t      xStride;
+            size_t      yStride;
+
+            Imf::PixelType type;
+            float          scale;
+            float          offset;
+        };
+
+        /**
+         * Planes of the channels over a box of the file. Each channel
+         * uses the plane of its type at its index in the targets.
+         */
+        struct Staging
+        {
+            std::vector<float>    floatValues;
+            std::vector<uint16_t> halfValues;
+            std::vector<uint32_t> uintValues;
+        };
+
+        /** Parts are opened the first time they are read. */
+        Imf::InputPart &     scanlinePart(int part);
+        Imf::TiledInputPart &tiledPart(int part);
+
+        /**
+         * Whether some values are converted or staged rather than read
+         * in place in the targets.
+         */
+        bool needsStaging(int part) const;
+
+        /** Allocates the planes for boxes of nPixels pixels. */
+        Staging staging(int part, size_t nPixels) const;
+
+        void readScanlines(int part);
+        void readTiles(int part);
+
+        /**
+         * Converts n values of a channel starting at index i of the
+         * staging planes. HALF values are converted by HalfConversion,
+         * UINT values by Quantisation.
+         *
+         * @returns the converted values, or the staged values when
+         * they need no conversion.
+         */
+        static const float *convert(
+          const Target & t,
+          const Staging &staging,
+          size_t         i,
+          size_t         n,
+          float *        converted);
+
+        /**
+         * Converts and copies the part of the region covered by a box
+         * of the file from the staging planes. The rows are
+         * transposed in parallel.
+         */
+        void copyFromStaging(
+          int part, const Staging &staging, const Imath::Box2i &box);
+
+        /**
+         * Frame buffer reading the channels in the targets, or in the
+         * staging planes covering a box of the file.
+         */
+        Imf::FrameBuffer frameBuffer(int part) const;
+        Imf::FrameBuffer
+        frameBuffer(int part, Staging &staging, const Imath::Box2i &box) const;
+
+        std::unique_ptr<Imf::MultiPartInputFile>          _file;
+        Imf::Header                                       _header;
+        std::vector<std::unique_ptr<Imf::InputPart>>      _scanlineParts;
+        std::vector<std::unique_ptr<Imf::TiledInputPart>> _tiledParts;
+        int                                               _level;
+        Imath::Box2i                                      _region;
+        PlanarStaging::Transfer                           _transfer;
+
+        /** Channels to read, per part of the file. */
+        std::vector<std::vector<Target>> _targets;
+    };
+
+}   // namespace SEXR
@@ -0,0 +1,740 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "EXRChannelWriter.h"
+#include "EXRChannelName.h"
+#include "PlanarStaging.h"
+#include "Quantisation.h"
+
+#include <SpectralImage.h>
+#include <Threading.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <OpenEXR/OpenEXRConfig.h>
+#include <OpenEXR/ImfChannelList.h>
+#include <OpenEXR/ImfFrameBuffer.h>
+#include <OpenEXR/ImfMultiPartOutputFile.h>
+#include <OpenEXR/ImfOutputFile.h>
+#include <OpenEXR/ImfOutputPart.h>
+#include <OpenEXR/ImfPartType.h>
+#include <OpenEXR/ImfStandardAttributes.h>
+#include <OpenEXR/ImfTiledOutputFile.h>
+#include <OpenEXR/ImfTiledOutputPart.h>
+
+namespace SEXR
+{
+    EXRChannelWriter::EXRChannelWriter(size_t width, size_t height)
+      : _width(width)
+      , _height(height)
+      , _header(width, height)
+      , _transfer(PlanarStaging::AUTOMATIC)
+      , _nextRow(0)
+    {}
+
+
+    void EXRChannelWriter::addChannel(
+      const std::string &name,
+      const float *      base,
+      size_t             xStride,
+      size_t             yStride,
+      Imf::PixelType     type,
+      float              scale,
+      float              offset)
+    {
+        if (type != Imf::FLOAT && type != Imf::HALF && type != Imf::UINT) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        // The library converts the FLOAT slices to HALF, UINT values
+        // are quantised by frameBuffer()
+        _header.channels().insert(name, Imf::Channel(type));
+
+        Source source
+          = {name, (const char *)base, xStride, yStride, type, scale, offset};
+        _sources.push_back(source);
+    }
+
+
+    void EXRChannelWriter::write(
+      const std::string &filename, const SaveOptions &options)
+    {
+        scaleSources();
+
+        if (options.multiPart) {
+            writeMultiPart(filename, options);
+            return;
+        }
+
+        setLayout(_header, options.layout);
+
+        if (options.layout.tiled) {
+            Imf::TiledOutputFile exrOut(
+              filename.c_str(),
+              _header,
+              Threading::openEXRThreadCount());
+            writeLevels(exrOut, _sources);
+        } else {
+            Imf::OutputFile exrOut(
+              filename.c_str(),
+              _header,
+              Threading::openEXRThreadCount());
+            writeScanlines(exrOut, _sources);
+        }
+    }
+
+
+    void EXRChannelWriter::open(
+      const std::string &filename, const SaveOptions &options)
+    {
+        // Tiles and parts are not written in row order, and scaled or
+        // quantised values need the range of the whole image
+        if (options.multiPart || options.layout.tiled) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        for (const Source &s : _sources) {
+            if (s.type == Imf::UINT || s.scale != 1.F || s.offset != 0.F) {
+                throw SpectralImage::INVALID_OPTIONS;
+            }
+        }
+
+        setLayout(_header, options.layout);
+
+        _stream.reset(new Imf::OutputFile(
+          filename.c_str(),
+          _header,
+          Threading::openEXRThreadCount()));
+        _nextRow = 0;
+    }
+
+
+    void EXRChannelWriter::writeRows(
+      size_t nRows, const std::vector<const float *> &rows)
+    {
+        if (
+          !_stream || rows.size() != _sources.size()
+          || nRows > _height - _nextRow) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        std::vector<Source> sources = _sources;
+
+        for (size_t c = 0; c < sources.size(); c++) {
+            sources[c].base = (const char *)rows[c];
+        }
+
+        const Runs runs = stagedRuns(sources);
+
+        // Interleaved sources are staged by chunks of compression
+        // blocks, the others are read from the rows
+        int chunkLines = std::max(int(nRows), 1);
+
+        if (!runs.empty()) {
+            chunkLines = PlanarStaging::chunkLines(
+              PlanarStaging::linesPerBlock(_header.compression()),
+              PlanarStaging::nChannels(runs) * _width * sizeof(float));
+        }
+
+        const int firstRow = int(_nextRow);
+        const int lastRow  = firstRow + int(nRows) - 1;
+
+        for (int y0 = firstRow; y0 <= lastRow; y0 += chunkLines) {
+            const int y1 = std::min(y0 + chunkLines - 1, lastRow);
+
+            const Imath::Box2i chunk(
+              Imath::V2i(0, y0),
+              Imath::V2i(int(_width) - 1, y1));
+
+            Imf::FrameBuffer exrFrameBuffer;
+
+            for (const Source &s : sources) {
+                exrFrameBuffer.insert(
+                  s.name,
+                  Imf::Slice::Make(
+                    Imf::FLOAT,
+                    s.base + (y0 - firstRow) * s.yStride,
+                    chunk,
+                    s.xStride,
+                    s.yStride));
+            }
+
+            if (!runs.empty()) {
+                stage(
+                  sources,
+                  runs,
+                  chunk,
+                  firstRow,
+                  _streamPlanes,
+                  exrFrameBuffer);
+            }
+
+            _stream->setFrameBuffer(exrFrameBuffer);
+            _stream->writePixels(y1 - y0 + 1);
+        }
+
+        _nextRow += nRows;
+    }
+
+
+    SaveOptions::Part EXRChannelWriter::part(const std::string &name)
+    {
+        int    polarisationComponent;
+        double wavelength_nm, reradiation_wavelength_nm;
+
+        const SpectrumType type = EXRChannelName::parse(
+          name,
+          polarisationComponent,
+          wavelength_nm,
+          reradiation_wavelength_nm);
+
+        if (isBispectralSpectrum(type)) {
+            return SaveOptions::RERADIATION_PART;
+        } else if (isReflectiveSpectrum(type)) {
+            return SaveOptions::DIAGONAL_PART;
+        } else if (isEmissiveSpectrum(type)) {
+            return polarisationComponent == 0 ? SaveOptions::S0_PART
+                                              : SaveOptions::POLARISATION_PART;
+        }
+
+        return SaveOptions::RGB_PART;
+    }
+
+
+    void EXRChannelWriter::writeMultiPart(
+      const std::string &filename, const SaveOptions &options)
+    {
+        static const char *partNames[SaveOptions::N_PARTS]
+          = {"rgb", "S0", "polarisation", "diagonal", "reradiation"};
+
+        std::vector<std::vector<Source>> partSources(SaveOptions::N_PARTS);
+
+        for (const Source &s : _sources) {
+            partSources[part(s.name)].push_back(s);
+        }
+
+        // Each part holds the attributes of the file, so every part
+        // describes the image on its own. Empty parts are not written
+        std::vector<Imf::Header>       headers;
+        std::vector<SaveOptions::Part> parts;
+
+        for (int p = 0; p < SaveOptions::N_PARTS; p++) {
+            const SaveOptions::Layout &layout = options.partLayouts[p];
+
+            if (partSources[p].empty()) {
+                continue;
+            }
+
+            Imf::Header header = _header;
+            header.channels()  = Imf::ChannelList();
+
+            for (const Source &s : partSources[p]) {
+                header.channels().insert(
+                  s.name,
+                  *_header.channels().findChannel(s.name));
+            }
+
+            setLayout(header, layout);
+            header.setName(partNames[p]);
+            header.setType(layout.tiled ? Imf::TILEDIMAGE : Imf::SCANLINEIMAGE);
+
+            headers.push_back(header);
+            parts.push_back(SaveOptions::Part(p));
+        }
+
+        Imf::MultiPartOutputFile exrOut(
+          filename.c_str(),
+          headers.data(),
+          int(headers.size()),
+          false,
+          Threading::openEXRThreadCount());
+
+        for (size_t i = 0; i < parts.size(); i++) {
+            const std::vector<Source> &sources = partSources[parts[i]];
+
+            if (options.partLayouts[parts[i]].tiled) {
+                Imf::TiledOutputPart exrPart(exrOut, int(i));
+                writeLevels(exrPart, sources);
+            } else {
+                Imf::OutputPart exrPart(exrOut, int(i));
+                writeScanlines(exrPart, sources);
+            }
+        }
+    }
+
+
+    std::vector<float> EXRChannelWriter::halfScales(
+      const std::vector<float> *buffers,
+      size_t                    nBuffers,
+      size_t                    nBands)
+    {
+        std::vector<float> maxValues(nBands, 0.F);
+
+        for (size_t b = 0; b < nBuffers; b++) {
+            for (size_t i = 0; i < buffers[b].size(); i++) {
+                float &maxValue = maxValues[i % nBands];
+                maxValue        = std::max(maxValue, std::abs(buffers[b][i]));
+            }
+        }
+
+        std::vector<float> scales(nBands, 1.F);
+
+        for (size_t i = 0; i < nBands; i++) {
+            if (maxValues[i] > 0.F && std::isfinite(maxValues[i])) {
+                // maxValue / 32768 < 2^exponent
+                int exponent;
+                std::frexp(maxValues[i] / 32768.F, &exponent);
+
+                scales[i] = std::ldexp(1.F, std::max(exponent, -100));
+            }
+        }
+
+        return scales;
+    }
+
+
+    void EXRChannelWriter::scaleSources()
+    {
+        const int nRows    = static_cast<int>(_height);
+        const int nThreads = static_cast<int>(Threading::threadCount());
+
+        for (Source &s : _sources) {
+            // Quantised sources are scaled by frameBuffer()
+            if (s.type == Imf::UINT || (s.scale == 1.F && s.offset == 0.F)) {
+                continue;
+            }
+
+            _scaledValues.emplace_back(_width * _height);
+            float *values = _scaledValues.back().data();
+
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads)
+            for (int y = 0; y < nRows; y++) {
+                const char *row = s.base + y * s.yStride;
+
+                for (size_t x = 0; x < _width; x++) {
+                    values[y * _width + x]
+                      = (*(const float *)(row + x * s.xStride) - s.offset)
+                        / s.scale;
+                }
+            }
+
+            s.base    = (const char *)values;
+            s.xStride = sizeof(float);
+            s.yStride = sizeof(float) * _width;
+            s.scale   = 1.F;
+            s.offset  = 0.F;
+        }
+    }
+
+
+    Imf::FrameBuffer EXRChannelWriter::frameBuffer(
+      const std::vector<Source> &sources, size_t width, size_t height)
+    {
+        const int nRows    = static_cast<int>(height);
+        const int nThreads = static_cast<int>(Threading::threadCount());
+
+        Imf::FrameBuffer exrFrameBuffer;
+        size_t           nQuantised = 0;
+
+        for (const Source &s : sources) {
+            if (s.type != Imf::UINT) {
+                exrFrameBuffer.insert(
+                  s.name,
+                  Imf::Slice(Imf::FLOAT, (char *)s.base, s.xStride, s.yStride));
+                continue;
+            }
+
+            if (_quantisedValues.size() == nQuantised) {
+                _quantisedValues.emplace_back();
+            }
+
+            std::vector<uint32_t> &levels = _quantisedValues[nQuantised++];
+            levels.resize(width * height);
+
+#pragma omp parallel num_threads(nThreads)
+            {
+                std::vector<float> row(width);
+
+#pragma omp for schedule(dynamic)
+                for (int y = 0; y < nRows; y++) {
+                    const char *src = s.base + y * s.yStride;
+
+                    for (size_t x = 0; x < width; x++) {
+                        row[x] = *(const float *)(src + x * s.xStride);
+                    }
+
+                    Quantisation::quantise(
+                      row.data(),
+                      width,
+                      s.scale,
+                      s.offset,
+                      &levels[y * width]);
+                }
+            }
+
+            exrFrameBuffer.insert(
+              s.name,
+              Imf::Slice(
+                Imf::UINT,
+                (char *)levels.data(),
+                sizeof(uint32_t),
+                sizeof(uint32_t) * width));
+        }
+
+        return exrFrameBuffer;
+    }
+
+
+    EXRChannelWriter::Runs
+    EXRChannelWriter::stagedRuns(const std::vector<Source> &sources) const
+    {
+        // Quantised sources are already planar
+        return PlanarStaging::runs(sources, [this](const Source &s) {
+            return s.type != Imf::UINT
+                   && PlanarStaging::isStaged(_transfer, s.xStride);
+        });
+    }
+
+
+    void EXRChannelWriter::stage(
+      const std::vector<Source> &sources,
+      const Runs &               runs,
+      const Imath::Box2i &       box,
+      int                        firstRow,
+      std::vector<float> &       planes,
+      Imf::FrameBuffer &         exrFrameBuffer) const
+    {
+        const size_t boxWidth  = box.max.x - box.min.x + 1;
+        const size_t boxPixels = boxWidth * (box.max.y - box.min.y + 1);
+
+        planes.resize(PlanarStaging::nChannels(runs) * boxPixels);
+
+        // The staged slices replace the slices of the sources
+        std::vector<size_t> firstPlanes(runs.size());
+        size_t              p = 0;
+
+        for (size_t r = 0; r < runs.size(); r++) {
+            firstPlanes[r] = p;
+
+            for (size_t c : runs[r]) {
+                exrFrameBuffer.insert(
+                  sources[c].name,
+                  Imf::Slice::Make(
+                    Imf::FLOAT,
+                    &planes[p++ * boxPixels],
+                    box,
+                    sizeof(float),
+                    sizeof(float) * boxWidth));
+            }
+        }
+
+        const int nThreads = static_cast<int>(Threading::threadCount());
+
+#pragma omp parallel num_threads(nThreads)
+        {
+            std::vector<float *> rowPlanes;
+
+#pragma omp for schedule(dynamic)
+            for (int y = box.min.y; y <= box.max.y; y++) {
+                const size_t row = (y - box.min.y) * boxWidth;
+
+                for (size_t r = 0; r < runs.size(); r++) {
+                    const std::vector<size_t> &run = runs[r];
+                    const Source &             s   = sources[run.front()];
+
+                    rowPlanes.resize(run.size());
+
+                    for (size_t k = 0; k < run.size(); k++) {
+                        const size_t plane = firstPlanes[r] + k;
+                        rowPlanes[k]       = &planes[plane * boxPixels + row];
+                    }
+
+                    const char *src = s.base + (y - firstRow) * s.yStride
+                                      + box.min.x * s.xStride;
+
+                    PlanarStaging::toPlanar(
+                      (const float *)src,
+                      s.xStride / sizeof(float),
+                      run.size(),
+                      boxWidth,
+                      rowPlanes.data());
+                }
+            }
+        }
+    }
+
+
+    template<typename Output>
+    void EXRChannelWriter::writeScanlines(
+      Output &exrOut, const std::vector<Source> &sources)
+    {
+        Imf::FrameBuffer exrFrameBuffer = frameBuffer(sources, _width, _height);
+        const Runs       runs           = stagedRuns(sources);
+
+        if (runs.empty()) {
+            exrOut.setFrameBuffer(exrFrameBuffer);
+            exrOut.writePixels(int(_height));
+            return;
+        }
+
+        // Interleaved sources are staged by chunks of compression blocks
+        const int chunkLines = PlanarStaging::chunkLines(
+          PlanarStaging::linesPerBlock(exrOut.header().compression()),
+          PlanarStaging::nChannels(runs) * _width * sizeof(float));
+
+        std::vector<float> planes;
+
+        for (int y0 = 0; y0 < int(_height); y0 += chunkLines) {
+            const int y1 = std::min(y0 + chunkLines, int(_height)) - 1;
+
+            const Imath::Box2i chunk(
+              Imath::V2i(0, y0),
+              Imath::V2i(int(_width) - 1, y1));
+
+            stage(sources, runs, chunk, 0, planes, exrFrameBuffer);
+
+            exrOut.setFrameBuffer(exrFrameBuffer);
+            exrOut.writePixels(y1 - y0 + 1);
+        }
+    }
+
+
+    void EXRChannelWriter::setLayout(
+      Imf::Header &header, const SaveOptions::Layout &layout)
+    {
+        if (
+          layout.compression >= Imf::NUM_COMPRESSION_METHODS
+          || (layout.tiled
+              && (layout.tileWidth == 0 || layout.tileHeight == 0
+                  || (layout.levelMode != Imf::ONE_LEVEL
+                      && layout.levelMode != Imf::MIPMAP_LEVELS)))) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        if (layout.tiled) {
+            header.setTileDescription(Imf::TileDescription(
+              layout.tileWidth,
+              layout.tileHeight,
+              layout.levelMode,
+              Imf::ROUND_DOWN));
+        }
+
+        header.compression() = layout.compression;
+
+        if (layout.compressionLevel < 0) {
+            return;
+        }
+
+        switch (layout.compression) {
+            case Imf::ZIPS_COMPRESSION:
+            case Imf::ZIP_COMPRESSION:
+#if OPENEXR_VERSION_MAJOR > 3 \
+  || (OPENEXR_VERSION_MAJOR == 3 && OPENEXR_VERSION_MINOR >= 1)
+                header.zipCompressionLevel() = int(layout.compressionLevel);
+#endif
+                break;
+
+            case Imf::DWAA_COMPRESSION:
+            case Imf::DWAB_COMPRESSION:
+#if OPENEXR_VERSION_MAJOR > 3 \
+  || (OPENEXR_VERSION_MAJOR == 3 && OPENEXR_VERSION_MINOR >= 1)
+                header.dwaCompressionLevel() = layout.compressionLevel;
+#else
+                // Older versions read the level from an attribute
+                Imf::addDwaCompressionLevel(header, layout.compressionLevel);
+#endif
+                break;
+
+            default:
+                break;
+        }
+    }
+
+
+    template<typename TiledOutput>
+    void EXRChannelWriter::writeLevels(
+      TiledOutput &exrOut, std::vector<Source> sources)
+    {
+        // Levels below the full resolution are computed in parallel
+        // from the previous level, only the last one is kept in memory
+        std::vector<float>  level, nextLevel;
+        size_t              width  = _width;
+        size_t              height = _height;
+
+        for (int l = 0; l < exrOut.numLevels(); l++) {
+            if (l > 0) {
+                const size_t levelWidth  = exrOut.levelWidth(l);
+                const size_t levelHeight = exrOut.levelHeight(l);
+
+                downsample(
+                  sources,
+                  width,
+                  height,
+                  levelWidth,
+                  levelHeight,
+                  nextLevel);
+
+                level.swap(nextLevel);
+
+                for (size_t c = 0; c < sources.size(); c++) {
+                    sources[c].base
+                      = (const char *)&level[c * levelWidth * levelHeight];
+                    sources[c].xStride = sizeof(float);
+                    sources[c].yStride = sizeof(float) * levelWidth;
+                }
+
+                width  = levelWidth;
+                height = levelHeight;
+            }
+
+            Imf::FrameBuffer exrFrameBuffer
+              = frameBuffer(sources, width, height);
+            const Runs runs = stagedRuns(sources);
+
+            const int nXTiles = exrOut.numXTiles(l);
+            const int nYTiles = exrOut.numYTiles(l);
+
+            if (runs.empty()) {
+                exrOut.setFrameBuffer(exrFrameBuffer);
+                exrOut.writeTiles(0, nXTiles - 1, 0, nYTiles - 1, l);
+                continue;
+            }
+
+            // Interleaved sources are staged by rows of tiles
+            const int tileHeight = exrOut.tileYSize();
+            const int tileRows
+              = PlanarStaging::chunkLines(
+                  tileHeight,
+                  PlanarStaging::nChannels(runs) * width * sizeof(float))
+                / tileHeight;
+
+            std::vector<float> planes;
+
+            for (int dy0 = 0; dy0 < nYTiles; dy0 += tileRows) {
+                const int dy1 = std::min(dy0 + tileRows, nYTiles) - 1;
+
+                const Imath::Box2i chunk(
+                  exrOut.dataWindowForTile(0, dy0, l).min,
+                  exrOut.dataWindowForTile(nXTiles - 1, dy1, l).max);
+
+                stage(sources, runs, chunk, 0, planes, exrFrameBuffer);
+
+                exrOut.setFrameBuffer(exrFrameBuffer);
+                exrOut.writeTiles(0, nXTiles - 1, dy0, dy1, l);
+            }
+        }
+    }
+
+
+    std::vector<EXRChannelWriter::Footprint>
+    EXRChannelWriter::footprints(size_t size, size_t levelSize)
+    {
+        std::vector<Footprint> result(levelSize);
+
+        const double scale = double(size) / double(levelSize);
+
+        for (size_t i = 0; i < levelSize; i++) {
+            const double start = i * scale;
+            const double end   = (i + 1) * scale;
+
+            Footprint &f = result[i];
+            f.first      = size_t(start);
+            f.count      = 0;
+
+            for (size_t s = f.first; s < size && s < end && f.count < 3; s++) {
+                const double overlap
+                  = std::min(end, s + 1.) - std::max(start, double(s));
+
+                f.weights[f.count++] = float(overlap / scale);
+            }
+        }
+
+        return result;
+    }
+
+
+    void EXRChannelWriter::downsample(
+      const std::vector<Source> &sources,
+      size_t                     width,
+      size_t                     height,
+      size_t                     levelWidth,
+      size_t                     levelHeight,
+      std::vector<float> &       level)
+    {
+        level.resize(sources.size() * levelWidth * levelHeight);
+
+        const std::vector<Footprint> columns = footprints(width, levelWidth);
+        const std::vector<Footprint> rows    = footprints(height, levelHeight);
+
+        const int nRows    = static_cast<int>(levelHeight);
+        const int nThreads = static_cast<int>(Threading::threadCount());
+
+        // Rows of the level are independent: each thread filters every
+        // channel of the next row
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads)
+        for (int y = 0; y < nRows; y++) {
+            const Footprint &fy = rows[y];
+
+            for (size_t c = 0; c < sources.size(); c++) {
+                const Source &s = sources[c];
+                float *dest = &level[(c * levelHeight + y) * levelWidth];
+
+                for (size_t x = 0; x < levelWidth; x++) {
+                    const Footprint &fx    = columns[x];
+                    float            value = 0.F;
+
+                    for (size_t j = 0; j < fy.count; j++) {
+                        const char *row = s.base + (fy.first + j) * s.yStride;
+                        float       rowValue = 0.F;
+
+                        for (size_t i = 0; i < fx.count; i++) {
+                            rowValue += fx.weights[i]
+                                        * *(const float *)(row
+                                                           + (fx.first + i)
+                                                               * s.xStride);
+                        }
+
+                        value += fy.weights[j] * rowValue;
+                    }
+
+                    dest[x] = value;
+                }
+            }
+        }
+    }
+
+}   // namespace SEXR
@@ -0,0 +1,287 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <OpenEXR/ImfHeader.h>
+#include <OpenEXR/ImfOutputFile.h>
+
+#include <SaveOptions.h>
+
+#include "PlanarStaging.h"
+
+namespace SEXR
+{
+    /**
+     * Writes float channels stored in arbitrary strided buffers to a
+     * scanline or tiled EXR file, as FLOAT, HALF or quantised UINT
+     * values. For tiled files with mipmap levels, each level is
+     * area filtered from the previous one, starting from the full
+     * resolution channels.
+     *
+     * Scanline files can also be written by blocks of rows, see
+     * open() and writeRows().
+     */
+    class EXRChannelWriter
+    {
+      public:
+        /**
+         * @param width width of the image.
+         * @param height height of the image.
+         */
+        EXRChannelWriter(size_t width, size_t height);
+
+        /**
+         * Header of the file, where the attributes are to be
+         * inserted. The channels are inserted by addChannel().
+         */
+        Imf::Header &header() { return _header; }
+
+        /**
+         * Adds a channel to write. The value of the pixel x, y is read
+         * at base + y * yStride + x * xStride.
+         *
+         * @param name name of the channel in the file.
+         * @param base address of the value of the top left pixel,
+         * ignored when the rows are written by writeRows().
+         * @param xStride offset in bytes between two columns, a
+         * multiple of sizeof(float).
+         * @param yStride offset in bytes between two rows.
+         * @param type type the values are stored with. UINT values
+         * are quantised to 16 bits, see Quantisation.
+         * @param scale the values are stored as (value - offset) /
+         * scale.
+         * @param offset see scale.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if the type is not
+         * supported.
+         */
+        void addChannel(
+          const std::string &name,
+          const float *      base,
+          size_t             xStride,
+          size_t             yStride,
+          Imf::PixelType     type   = Imf::FLOAT,
+          float              scale  = 1.F,
+          float              offset = 0.F);
+
+        /**
+         * Sets how the values are handed to OpenEXR. By default,
+         * channels interleaved with a stride wider than a cache line
+         * are transposed to planar staging buffers by chunks of
+         * scanlines or rows of tiles before being encoded.
+         */
+        void setTransfer(PlanarStaging::Transfer transfer)
+        {
+            _transfer = transfer;
+        }
+
+        /**
+         * Writes the file. For multipart files, each channel goes to
+         * the part of its kind, see SaveOptions::Part.
+         *
+         * @param filename path where the file shall be written.
+         * @param options layout and compression of the file.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if the tiles are
+         * empty, the level mode is not supported or the compression
+         * method is unknown.
+         */
+        void write(const std::string &filename, const SaveOptions &options);
+
+        /**
+         * Creates a scanline file whose rows are then written in
+         * increasing order by writeRows(). The header and the
+         * channels cannot be changed once the file is created.
+         *
+         * @param filename path where the file shall be written.
+         * @param options compression of the file.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if the options ask
+         * for tiles or parts, or a channel is scaled or quantised:
+         * these need the whole image.
+         */
+        void open(const std::string &filename, const SaveOptions &options);
+
+        /**
+         * Writes the next rows of a file created by open(). The value
+         * of the pixel x of the row r of the block is read at
+         * rows[c] + r * yStride + x * xStride for the channel c.
+         *
+         * @param nRows number of rows to write.
+         * @param rows address of the value of the first pixel of the
+         * block for each channel, in the order they were added.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if no file is open,
+         * the number of channels does not match or the image has
+         * fewer rows left.
+         */
+        void writeRows(size_t nRows, const std::vector<const float *> &rows);
+
+        /** Index of the next row writeRows() writes. */
+        size_t nextRow() const { return _nextRow; }
+
+        /** Part of a multipart file where a channel is written. */
+        static SaveOptions::Part part(const std::string &name);
+
+        /**
+         * Computes for each band of interleaved pixel buffers the
+         * power of two bringing its largest magnitude just below
+         * 32768, where HALF values keep the most precision without
+         * overflowing. Dividing by a power of two is exact.
+         *
+         * @param buffers buffers storing nBands values per pixel.
+         * @param nBuffers number of buffers, the scale of a band is
+         * shared by all the buffers.
+         * @param nBands number of bands.
+         */
+        static std::vector<float> halfScales(
+          const std::vector<float> *buffers,
+          size_t                    nBuffers,
+          size_t                    nBands);
+
+      private:
+        /** Sets the tiling and compression of a file or a part. */
+        static void
+        setLayout(Imf::Header &header, const SaveOptions::Layout &layout);
+
+        struct Source
+        {
+            std::string name;
+            const char *base;
+            size_t      xStride;
+            size_t      yStride;
+
+            Imf::PixelType type;
+            float          scale;
+            float          offset;
+        };
+
+        /**
+         * Replaces the scaled FLOAT and HALF sources by copies of the
+         * scaled values.
+         */
+        void scaleSources();
+
+        /**
+         * Frame buffer writing the sources of a level. FLOAT slices
+         * point to the sources, UINT slices to quantised copies.
+         */
+        Imf::FrameBuffer frameBuffer(
+          const std::vector<Source> &sources, size_t width, size_t height);
+
+        /** Indices of the sources of each transposed run. */
+        typedef std::vector<std::vector<size_t>> Runs;
+
+        Runs stagedRuns(const std::vector<Source> &sources) const;
+
+        /**
+         * Transposes the rows of a box of the staged sources to
+         * planes, and points their slices to the planes. The base of
+         * the sources is the row firstRow.
+         */
+        void stage(
+          const std::vector<Source> &sources,
+          const Runs &               runs,
+          const Imath::Box2i &       box,
+          int                        firstRow,
+          std::vector<float> &       planes,
+          Imf::FrameBuffer &         exrFrameBuffer) const;
+
+        /** Writes a scanline file or part. */
+        template<typename Output>
+        void writeScanlines(Output &exrOut, const std::vector<Source> &sources);
+
+        void
+        writeMultiPart(const std::string &filename, const SaveOptions &options);
+
+        /**
+         * Writes every level of a tiled file or part. Each level below
+         * the full resolution is filtered from the previous level.
+         */
+        template<typename TiledOutput>
+        void writeLevels(TiledOutput &exrOut, std::vector<Source> sources);
+
+        /**
+         * Source pixels covered by a pixel of the next level, with
+         * their share of its area. As level sizes are rounded down, a
+         * pixel covers at most 3 source pixels along each axis.
+         */
+        struct Footprint
+        {
+            size_t first;
+            size_t count;
+            float  weights[3];
+        };
+
+        static std::vector<Footprint>
+        footprints(size_t size, size_t levelSize);
+
+        /**
+         * Computes the next mipmap level of every channel. Each pixel
+         * of the level is the average of the source pixels it covers,
+         * weighted by the covered area, so odd sizes are filtered
+         * without shift.
+         */
+        static void downsample(
+          const std::vector<Source> &sources,
+          size_t                     width,
+          size_t                     height,
+          size_t                     levelWidth,
+          size_t                     levelHeight,
+          std::vector<float> &       level);
+
+        size_t              _width, _height;
+        Imf::Header         _header;
+        std::vector<Source> _sources;
+
+        std::vector<std::vector<float>>    _scaledValues;
+        std::vector<std::vector<uint32_t>> _quantisedValues;
+
+        PlanarStaging::Transfer _transfer;
+
+        // File written by writeRows()
+        std::unique_ptr<Imf::OutputFile> _stream;
+        size_t                           _nextRow;
+        std::vector<float>               _streamPlanes;
+    };
+
+}   // namespace SEXR
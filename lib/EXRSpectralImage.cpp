@@ -36,16 +36,19 @@
 
 #include <EXRSpectralImage.h>
 #include "Util.h"
+#include "EXRChannelReader.h"
+#include "EXRChannelWriter.h"
+#include "Quantisation.h"
+#include "EXRChannelName.h"
 
-#include <regex>
 #include <algorithm>
-#include <sstream>
 #include <cassert>
 
 #include <OpenEXR/ImfInputFile.h>
 #include <OpenEXR/ImfOutputFile.h>
 #include <OpenEXR/ImfChannelList.h>
 #include <OpenEXR/ImfStringAttribute.h>
+#include <OpenEXR/ImfFloatVectorAttribute.h>
 #include <OpenEXR/ImfFrameBuffer.h>
 
 namespace SEXR
@@ -60,130 +63,39 @@ namespace SEXR
     {}
 
 
-    EXRSpectralImage::EXRSpectralImage(const std::string &filename)
+    EXRSpectralImage::EXRSpectralImage(
+      const std::string &filename, const LoadOptions &options)
       : SpectralImage()
     {
-        Imf::InputFile      exrIn(filename.c_str());
-        const Imf::Header & exrHeader     = exrIn.header();
-        const Imath::Box2i &exrDataWindow = exrHeader.dataWindow();
+        EXRChannelReader   exrReader(filename);
+        const Imf::Header &exrHeader = exrReader.header();
 
-        _width        = exrDataWindow.max.x - exrDataWindow.min.x + 1;
-        _height       = exrDataWindow.max.y - exrDataWindow.min.y + 1;
-        _spectrumType = UNDEFINED;
+        exrReader.setLevel(options.level);
 
-        // ---------------------------------------------------------------------
-        // Determine channels' position
-        // ---------------------------------------------------------------------
+        const Imath::Box2i exrDataWindow = exrReader.dataWindow();
 
-        const Imf::ChannelList &exrChannels = exrHeader.channels();
-
-        std::array<std::vector<std::pair<float, std::string>>, 4>
-                                                   wavelengths_nm_S;
-        std::vector<std::pair<float, std::string>> wavelengths_nm_reflective;
-
-        for (Imf::ChannelList::ConstIterator channel = exrChannels.begin();
-             channel != exrChannels.end();
-             channel++) {
-            // Check if the channel is a spectral one
-            int          polarisationComponent;
-            double       wavelength_nm;
-            SpectrumType spectralChannel = channelType(
-              channel.name(),
-              polarisationComponent,
-              wavelength_nm);
-
-            if (spectralChannel != SpectrumType::UNDEFINED) {
-                _spectrumType = _spectrumType | spectralChannel;
-
-                if (isEmissiveSpectrum(spectralChannel)) {
-                    wavelengths_nm_S[polarisationComponent].push_back(
-                      std::make_pair(wavelength_nm, channel.name()));
-                } else if (isReflectiveSpectrum(spectralChannel)) {
-                    wavelengths_nm_reflective.push_back(
-                      std::make_pair(wavelength_nm, channel.name()));
-                }
-            }
-        }
+        const Imath::Box2i exrRegion
+          = EXRChannelReader::loadRegion(exrDataWindow, options);
 
-        // Sort by ascending wavelengths
-        for (size_t s = 0; s < nStokesComponents(); s++) {
-            std::sort(wavelengths_nm_S[s].begin(), wavelengths_nm_S[s].end());
-        }
+        _width  = exrRegion.max.x - exrRegion.min.x + 1;
+        _height = exrRegion.max.y - exrRegion.min.y + 1;
 
-        if (isReflective()) {
-            std::sort(
-              wavelengths_nm_reflective.begin(),
-              wavelengths_nm_reflective.end());
-        }
+        invalidatePreview();
 
         // ---------------------------------------------------------------------
-        // Sanity check
+        // Determine channels' position
         // ---------------------------------------------------------------------
 
-        if (_spectrumType == SpectrumType::UNDEFINED) {
-            // Probably an RGB EXR, not our job to handle it
-            throw INCORRECT_FORMED_FILE;
-        }
+        const EXRChannelReader::SpectralChannels channels
+          = EXRChannelReader::spectralChannels(exrHeader, false, options);
 
-        if (isEmissive()) {
-            // Check we have the same wavelength for each Stokes component
-            // Wavelength vectors must be of the same size
-            const float base_size_emissive = wavelengths_nm_S[0].size();
-
-            for (size_t s = 1; s < nStokesComponents(); s++) {
-                if (wavelengths_nm_S[s].size() != base_size_emissive) {
-                    throw INCORRECT_FORMED_FILE;
-                }
-
-                // Wavelengths must correspond
-                for (size_t wl_idx = 0; wl_idx < base_size_emissive; wl_idx++) {
-                    if (
-                      wavelengths_nm_S[s][wl_idx].first
-                      != wavelengths_nm_S[0][wl_idx].first) {
-                        throw INCORRECT_FORMED_FILE;
-                    }
-                }
-            }
-        }
-
-        // If both reflective and emissive, we need to perform a last
-        // sanity check
-        if (isEmissive() && isReflective()) {
-            const size_t n_emissive_wavelengths = wavelengths_nm_S[0].size();
-            const size_t n_reflective_wavelengths
-              = wavelengths_nm_reflective.size();
-
-            if (n_emissive_wavelengths != n_reflective_wavelengths)
-                throw INCORRECT_FORMED_FILE;
-
-            for (size_t wl_idx = 0; wl_idx < n_emissive_wavelengths; wl_idx++) {
-                if (
-                  wavelengths_nm_S[0][wl_idx]
-                  != wavelengths_nm_reflective[wl_idx])
-                    throw INCORRECT_FORMED_FILE;
-            }
-        }
+        _spectrumType   = channels.type;
+        _wavelengths_nm = channels.wavelengths_nm;
 
         // ---------------------------------------------------------------------
         // Allocate memory
         // ---------------------------------------------------------------------
 
-        // Now, we can populate the local wavelength vector
-        if (isEmissive()) {
-            _wavelengths_nm.reserve(wavelengths_nm_S[0].size());
-
-            for (const auto &wl_index : wavelengths_nm_S[0]) {
-                _wavelengths_nm.push_back(wl_index.first);
-            }
-        } else {
-            _wavelengths_nm.reserve(wavelengths_nm_reflective.size());
-
-            for (const auto &wl_index : wavelengths_nm_reflective) {
-                _wavelengths_nm.push_back(wl_index.first);
-            }
-        }
-
-        // We allocate pixel buffers memory
         for (size_t s = 0; s < nStokesComponents(); s++) {
             _emissivePixelBuffers[s].resize(
               nSpectralBands() * width() * height());
@@ -198,46 +110,35 @@ namespace SEXR
         // Read the pixel data
         // ---------------------------------------------------------------------
 
-        Imf::FrameBuffer exrFrameBuffer;
+        exrReader.setRegion(exrRegion);
 
-        const Imf::PixelType compType = Imf::FLOAT;
-        const size_t         xStride  = sizeof(float) * nSpectralBands();
-        const size_t         yStride  = xStride * _width;
+        const size_t xStride = sizeof(float) * nSpectralBands();
+        const size_t yStride = xStride * _width;
 
         for (size_t s = 0; s < nStokesComponents(); s++) {
             for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
-                char *     ptrS  = (char *)(&_emissivePixelBuffers[s][wl_idx]);
-                Imf::Slice slice = Imf::Slice::Make(
-                  compType,
-                  ptrS,
-                  exrDataWindow,
+                exrReader.addChannel(
+                  channels.emissive[s][wl_idx].second,
+                  &_emissivePixelBuffers[s][wl_idx],
                   xStride,
-                  yStride);
-
-                exrFrameBuffer.insert(
-                  wavelengths_nm_S[s][wl_idx].second,
-                  slice);
+                  yStride,
+                  channels.emissiveScales[wl_idx]);
             }
         }
 
         if (isReflective()) {
             for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
-                char *     ptrS  = (char *)(&_reflectivePixelBuffer[wl_idx]);
-                Imf::Slice slice = Imf::Slice::Make(
-                  compType,
-                  ptrS,
-                  exrDataWindow,
+                exrReader.addChannel(
+                  channels.reflective[wl_idx].second,
+                  &_reflectivePixelBuffer[wl_idx],
                   xStride,
-                  yStride);
-
-                exrFrameBuffer.insert(
-                  wavelengths_nm_reflective[wl_idx].second,
-                  slice);
+                  yStride,
+                  channels.reflectiveScale,
+                  channels.reflectiveOffset);
             }
         }
 
-        exrIn.setFrameBuffer(exrFrameBuffer);
-        exrIn.readPixels(exrDataWindow.min.y, exrDataWindow.max.y);
+        exrReader.read();
 
         // ---------------------------------------------------------------------
         // Read metadata
@@ -301,10 +202,16 @@ namespace SEXR
         // Each channel sensitivity
         _channelSensitivities.resize(nSpectralBands());
 
-        for (size_t i = 0; i < wavelengths_nm_S[0].size(); i++) {
+        for (size_t i = 0; i < nSpectralBands(); i++) {
+            // Files without emissive channels may still name them
+            const std::string channelName
+              = i < channels.emissive[0].size()
+                  ? channels.emissive[0][i].second
+                  : getEmissiveChannelName(0, _wavelengths_nm[i]);
+
             const Imf::StringAttribute *filterTransmissionAttr
               = exrHeader.findTypedAttribute<Imf::StringAttribute>(
-                wavelengths_nm_S[0][i].second);
+                channelName);
 
             if (filterTransmissionAttr != nullptr) {
                 try {
@@ -348,17 +255,20 @@ namespace SEXR
 
     void EXRSpectralImage::save(const std::string &filename) const
     {
-        Imf::Header       exrHeader(width(), height());
-        Imf::ChannelList &exrChannels = exrHeader.channels();
+        save(filename, SaveOptions());
+    }
+
+
+    void EXRSpectralImage::save(
+      const std::string &filename, const SaveOptions &options) const
+    {
+        EXRChannelWriter exrWriter(width(), height());
+        Imf::Header &    exrHeader = exrWriter.header();
 
         // ---------------------------------------------------------------------
         // Write the pixel data
         // ---------------------------------------------------------------------
 
-        // Layout framebuffer
-        Imf::FrameBuffer     exrFrameBuffer;
-        const Imf::PixelType compType = Imf::FLOAT;
-
         // Write RGB version
         std::vector<float> rgbImage;
         getRGBImage(rgbImage);
@@ -368,43 +278,82 @@ namespace SEXR
         const size_t                     yStrideRGB  = xStrideRGB * width();
 
         for (size_t c = 0; c < 3; c++) {
-            char *ptrRGB = (char *)(&rgbImage[c]);
-
-            exrChannels.insert(rgbChannels[c], Imf::Channel(compType));
-            exrFrameBuffer.insert(
+            exrWriter.addChannel(
               rgbChannels[c],
-              Imf::Slice(compType, ptrRGB, xStrideRGB, yStrideRGB));
+              &rgbImage[c],
+              xStrideRGB,
+              yStrideRGB);
         }
 
         // Write spectral version
         const size_t xStride = sizeof(float) * nSpectralBands();
         const size_t yStride = xStride * width();
 
+        // Emissive values are not bounded
+        if (options.emissiveType == Imf::UINT) {
+            throw INVALID_OPTIONS;
+        }
+
+        // HALF emissive bands may be scaled to fit the HALF range
+        std::vector<float> emissiveScales(nSpectralBands(), 1.F);
+
+        if (
+          isEmissive() && options.emissiveType == Imf::HALF
+          && options.scaleEmissive) {
+            emissiveScales = EXRChannelWriter::halfScales(
+              _emissivePixelBuffers.data(),
+              nStokesComponents(),
+              nSpectralBands());
+
+            exrHeader.insert(
+              EMISSIVE_SCALE_ATTR,
+              Imf::FloatVectorAttribute(emissiveScales));
+        }
+
         for (size_t s = 0; s < nStokesComponents(); s++) {
             for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
                 // Populate channel name
                 const std::string channelName
                   = getEmissiveChannelName(s, _wavelengths_nm[wl_idx]);
-                exrChannels.insert(channelName, Imf::Channel(compType));
-
-                char *ptrS = (char *)(&_emissivePixelBuffers[s][wl_idx]);
-                exrFrameBuffer.insert(
+                exrWriter.addChannel(
                   channelName,
-                  Imf::Slice(compType, ptrS, xStride, yStride));
+                  &_emissivePixelBuffers[s][wl_idx],
+                  xStride,
+                  yStride,
+                  options.emissiveType,
+                  emissiveScales[wl_idx]);
             }
         }
 
         if (isReflective()) {
+            // Quantised values are stored with their range
+            float reflectiveScale = 1.F, reflectiveOffset = 0.F;
+
+            if (options.reflectiveType == Imf::UINT) {
+                Quantisation::range(
+                  _reflectivePixelBuffer.data(),
+                  _reflectivePixelBuffer.size(),
+                  reflectiveScale,
+                  reflectiveOffset);
+
+                exrHeader.insert(
+                  REFLECTIVE_QUANTISATION_ATTR,
+                  Imf::FloatVectorAttribute(
+                    std::vector<float>({reflectiveScale, reflectiveOffset})));
+            }
+
             for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
                 // Populate channel name
                 const std::string channelName
                   = getReflectiveChannelName(_wavelengths_nm[wl_idx]);
-                exrChannels.insert(channelName, Imf::Channel(compType));
-
-                char *ptrS = (char *)(&_reflectivePixelBuffer[wl_idx]);
-                exrFrameBuffer.insert(
+                exrWriter.addChannel(
                   channelName,
-                  Imf::Slice(compType, ptrS, xStride, yStride));
+                  &_reflectivePixelBuffer[wl_idx],
+                  xStride,
+                  yStride,
+                  options.reflectiveType,
+                  reflectiveScale,
+                  reflectiveOffset);
             }
         }
 
@@ -462,9 +411,7 @@ namespace SEXR
         // Write file
         // ---------------------------------------------------------------------
 
-        Imf::OutputFile exrOut(filename.c_str(), exrHeader);
-        exrOut.setFrameBuffer(exrFrameBuffer);
-        exrOut.writePixels(height());
+        exrWriter.write(filename, options);
     }
 
 
@@ -473,61 +420,20 @@ namespace SEXR
       int &              polarisationComponent,
       double &           wavelength_nm)
     {
-        const std::regex expr(
-          "^((S([0-3]))|T)\\.(\\d*,?\\d*([Ee][+-]?\\d+)?)(Y|Z|E|P|T|G|M|k|h|"
-          "da|d|c|m|u|n|p)?(m|Hz)$");
-        std::smatch matches;
-
-        const bool matched = std::regex_search(channelName, matches, expr);
-
-        SpectrumType channelType = SpectrumType::UNDEFINED;
-
-        if (matched) {
-            if (matches.size() != 8) {
-                // Something went wrong with the parsing. This shall not occur.
-                throw INTERNAL_ERROR;
-            }
-
-            switch (matches[1].str()[0]) {
-                case 'S':
-                    channelType           = SpectrumType::EMISSIVE;
-                    polarisationComponent = std::stoi(matches[3].str());
-                    if (polarisationComponent > 0) {
-                        channelType = channelType | SpectrumType::POLARISED;
-                    }
-                    break;
-
-                case 'T':
-                    channelType = SpectrumType::REFLECTIVE;
-                    break;
-
-                default:
-                    return SpectrumType::UNDEFINED;
-            }
-
-            // Get value
-            std::string centralValueStr(matches[4].str());
-            std::replace(
-              centralValueStr.begin(),
-              centralValueStr.end(),
-              ',',
-              '.');
-            const double value = std::stod(centralValueStr);
+        double reradiation_wavelength_nm;
 
-            // Convert to nanometers
-            const std::string prefix = matches[6].str();
-            const std::string units  = matches[7].str();
+        const SpectrumType type = EXRChannelName::parse(
+          channelName,
+          polarisationComponent,
+          wavelength_nm,
+          reradiation_wavelength_nm);
 
-            try {
-                wavelength_nm = Util::strToNanometers(value, prefix, units);
-            } catch (std::out_of_range &exception) {
-                // Unknown unit or multiplier
-                // Something went wrong with the parsing. This shall not occur.
-                throw INTERNAL_ERROR;
-            }
+        // Reradiation channels are only handled by bispectral images
+        if (isBispectralSpectrum(type)) {
+            return SpectrumType::UNDEFINED;
         }
 
-        return channelType;
+        return type;
     }
 
 
@@ -536,13 +442,8 @@ namespace SEXR
     {
         assert(stokesComponent < 4);
 
-        std::stringstream b;
-        std::string       wavelengthStr = std::to_string(wavelength_nm);
-        std::replace(wavelengthStr.begin(), wavelengthStr.end(), '.', ',');
-
-        b << "S" << stokesComponent << "." << wavelengthStr << "nm";
-
-        const std::string channelName = b.str();
+        const std::string channelName
+          = EXRChannelName::emissive(stokesComponent, wavelength_nm);
 
 #ifndef NDEBUG
         int    polarisationComponentChecked;
@@ -564,14 +465,8 @@ namespace SEXR
 
     std::string EXRSpectralImage::getReflectiveChannelName(double wavelength_nm)
     {
-        std::stringstream b;
-        std::string       wavelengthStr = std::to_string(wavelength_nm);
-        std::replace(wavelengthStr.begin(), wavelengthStr.end(), '.', ',');
-
-        b << "T"
-          << "." << wavelengthStr << "nm";
-
-        const std::string channelName = b.str();
+        const std::string channelName
+          = EXRChannelName::reflective(wavelength_nm);
 
 #ifndef NDEBUG
         int    polarisationComponentChecked;
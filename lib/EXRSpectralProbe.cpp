@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "EXRChannelReader.h"
+
+#include <EXRSpectralProbe.h>
+#include <EXRBiSpectralImage.h>
+#include <Threading.h>
+
+#include <OpenEXR/ImfStringAttribute.h>
+#include <OpenEXR/ImfFloatAttribute.h>
+
+namespace SEXR
+{
+    EXRSpectralProbe::EXRSpectralProbe()
+      : _width(0)
+      , _height(0)
+      , _spectrumType(SpectrumType::UNDEFINED)
+      , _polarisationHandedness(SpectralImage::RIGHT_HANDED)
+      , _nLevels(1)
+      , _nReradiationChannels(0)
+      , _ev(0)
+    {}
+
+
+    EXRSpectralProbe::EXRSpectralProbe(const std::string &filename)
+      : EXRSpectralProbe(filename, Threading::openEXRThreadCount())
+    {}
+
+
+    EXRSpectralProbe::EXRSpectralProbe(
+      const std::string &filename, int nThreads)
+      : EXRSpectralProbe()
+    {
+        // The reader lists the channels of all the parts
+        EXRChannelReader    exrReader(filename, nThreads);
+        const Imf::Header & exrHeader     = exrReader.header();
+        const Imath::Box2i &exrDataWindow = exrHeader.dataWindow();
+
+        _filename = filename;
+        _width    = exrDataWindow.max.x - exrDataWindow.min.x + 1;
+        _height   = exrDataWindow.max.y - exrDataWindow.min.y + 1;
+        _nLevels  = exrReader.nLevels();
+
+        // --------------------------------------------------------------------
+        // Classify the channels
+        // --------------------------------------------------------------------
+
+        // Same checks as the images: a file which cannot be loaded is
+        // rejected
+        const EXRChannelReader::SpectralChannels channels
+          = EXRChannelReader::spectralChannels(exrHeader, true, LoadOptions());
+
+        _spectrumType         = channels.type;
+        _wavelengths_nm       = channels.wavelengths_nm;
+        _nReradiationChannels = channels.reradiation.size();
+
+        // --------------------------------------------------------------------
+        // Metadata
+        // --------------------------------------------------------------------
+
+        // Spectral attributes are parsed here rather than on access so
+        // that a probe can be read from several threads
+        const Imf::StringAttribute *lensTransmissionAttr
+          = exrHeader.findTypedAttribute<Imf::StringAttribute>(
+            EXRBiSpectralImage::LENS_TRANSMISSION_ATTR);
+
+        if (lensTransmissionAttr != nullptr) {
+            try {
+                _lensTransmission = SpectrumAttribute(*lensTransmissionAttr);
+            } catch (SpectrumAttribute::Error &e) {
+                throw SpectralImage::INCORRECT_FORMED_FILE;
+            }
+        }
+
+        const Imf::StringAttribute *cameraResponseAttr
+          = exrHeader.findTypedAttribute<Imf::StringAttribute>(
+            EXRBiSpectralImage::CAMERA_RESPONSE_ATTR);
+
+        if (cameraResponseAttr != nullptr) {
+            try {
+                _cameraResponse = SpectrumAttribute(*cameraResponseAttr);
+            } catch (SpectrumAttribute::Error &e) {
+                throw SpectralImage::INCORRECT_FORMED_FILE;
+            }
+        }
+
+        const Imf::FloatAttribute *exposureCompensationAttr
+          = exrHeader.findTypedAttribute<Imf::FloatAttribute>(
+            EXRBiSpectralImage::EXPOSURE_COMPENSATION_ATTR);
+
+        if (exposureCompensationAttr != nullptr) {
+            _ev = exposureCompensationAttr->value();
+        }
+
+        const Imf::StringAttribute *polarisationHandednessAttr
+          = exrHeader.findTypedAttribute<Imf::StringAttribute>(
+            EXRBiSpectralImage::POLARISATION_HANDEDNESS_ATTR);
+
+        if (polarisationHandednessAttr != nullptr) {
+            if (polarisationHandednessAttr->value() == "left") {
+                _polarisationHandedness = SpectralImage::LEFT_HANDED;
+            } else if (polarisationHandednessAttr->value() == "right") {
+                _polarisationHandedness = SpectralImage::RIGHT_HANDED;
+            } else {
+                throw SpectralImage::INCORRECT_FORMED_FILE;
+            }
+        }
+    }
+
+
+    std::vector<EXRSpectralProbe>
+    EXRSpectralProbe::probe(const std::vector<std::string> &filenames)
+    {
+        std::vector<EXRSpectralProbe> probes(filenames.size());
+
+        const int nFiles   = static_cast<int>(filenames.size());
+        const int nThreads = static_cast<int>(Threading::threadCount());
+
+        // Files are independent and mostly wait on I/O: each thread
+        // picks the next file to probe
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads)
+        for (int f = 0; f < nFiles; f++) {
+            // Exceptions cannot leave the parallel region, a file
+            // which fails keeps an empty probe
+            try {
+                // Only the header is read: the files are opened without
+                // the pool of OpenEXR, which would oversubscribe the
+                // threads of this loop
+                probes[f] = EXRSpectralProbe(filenames[f], 0);
+            } catch (...) {
+                probes[f]           = EXRSpectralProbe();
+                probes[f]._filename = filenames[f];
+            }
+        }
+
+        return probes;
+    }
+}   // namespace SEXR
@@ -0,0 +1,257 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <EXRSpectralStreamReader.h>
+#include "EXRChannelReader.h"
+#include "PlanarStaging.h"
+
+#include <algorithm>
+
+namespace SEXR
+{
+    EXRSpectralStreamReader::EXRSpectralStreamReader(
+      const std::string &filename,
+      const LoadOptions &options,
+      size_t             blockRows,
+      size_t             nBuffers)
+      : _reader(new EXRChannelReader(filename))
+      , _spectrumType(SpectrumType::UNDEFINED)
+      , _nextBlock(0)
+    {
+        const Imf::Header &exrHeader = _reader->header();
+
+        _reader->setLevel(options.level);
+
+        const Imath::Box2i exrDataWindow = _reader->dataWindow();
+
+        const Imath::Box2i exrRegion
+          = EXRChannelReader::loadRegion(exrDataWindow, options);
+
+        _width  = exrRegion.max.x - exrRegion.min.x + 1;
+        _height = exrRegion.max.y - exrRegion.min.y + 1;
+        _minX   = exrRegion.min.x;
+        _minY   = exrRegion.min.y;
+        _maxY   = exrRegion.max.y;
+
+        // ---------------------------------------------------------------------
+        // Determine channels' position
+        // ---------------------------------------------------------------------
+
+        const EXRChannelReader::SpectralChannels channels
+          = EXRChannelReader::spectralChannels(exrHeader, false, options);
+
+        _spectrumType   = channels.type;
+        _wavelengths_nm = channels.wavelengths_nm;
+
+        for (size_t b = 0; b < nSpectralBands(); b++) {
+            for (size_t s = 0; s < nStokesComponents(); s++) {
+                const Channel channel = {
+                  channels.emissive[s][b].second,
+                  channels.emissiveScales[b],
+                  0.F};
+                _emissiveChannels[s].push_back(channel);
+            }
+
+            if (isReflective()) {
+                const Channel channel = {
+                  channels.reflective[b].second,
+                  channels.reflectiveScale,
+                  channels.reflectiveOffset};
+                _reflectiveChannels.push_back(channel);
+            }
+        }
+
+        // ---------------------------------------------------------------------
+        // Allocate the ring of blocks
+        // ---------------------------------------------------------------------
+
+        const size_t nComponents
+          = nStokesComponents() + (isReflective() ? 1 : 0);
+
+        if (blockRows == 0) {
+            const int blockLines
+              = exrHeader.hasTileDescription()
+                  ? int(exrHeader.tileDescription().ySize)
+                  : PlanarStaging::linesPerBlock(exrHeader.compression());
+
+            blockRows = PlanarStaging::chunkLines(
+              blockLines,
+              sizeof(float) * _width * nSpectralBands() * nComponents);
+        }
+
+        // Blocks start on multiples of blockRows from the top of the
+        // file, where the compression blocks or tiles start
+        _blockRows   = blockRows;
+        _firstBlockY = _minY - (_minY - exrDataWindow.min.y) % int(_blockRows);
+        _nBlocks     = (_maxY - _firstBlockY) / _blockRows + 1;
+
+        _blocks.resize(std::max(nBuffers, size_t(1)));
+        _reads.resize(_blocks.size());
+
+        for (Block &block : _blocks) {
+            const size_t blockSize = _blockRows * _width * nSpectralBands();
+
+            block._width          = _width;
+            block._nSpectralBands = nSpectralBands();
+
+            for (size_t s = 0; s < nStokesComponents(); s++) {
+                block._emissive[s].resize(blockSize);
+            }
+
+            if (isReflective()) {
+                block._reflective.resize(blockSize);
+            }
+        }
+    }
+
+
+    EXRSpectralStreamReader::~EXRSpectralStreamReader()
+    {
+        // Each read waits for the previous one
+        if (_lastRead.valid()) {
+            _lastRead.wait();
+        }
+    }
+
+
+    const EXRSpectralStreamReader::Block *EXRSpectralStreamReader::next()
+    {
+        if (_nextBlock == 0) {
+            for (size_t b = 0; b < _blocks.size(); b++) {
+                schedule(b);
+            }
+        } else {
+            // The buffer of the previous block is free
+            schedule(_nextBlock - 1 + _blocks.size());
+        }
+
+        if (_nextBlock >= _nBlocks) {
+            return nullptr;
+        }
+
+        const size_t buffer = _nextBlock % _blocks.size();
+        _nextBlock++;
+
+        // Rethrows the errors of the read
+        _reads[buffer].get();
+
+        return &_blocks[buffer];
+    }
+
+
+    void EXRSpectralStreamReader::forEachBlock(
+      const std::function<void(const Block &)> &callback)
+    {
+        const Block *block;
+
+        while ((block = next()) != nullptr) {
+            callback(*block);
+        }
+    }
+
+
+    void EXRSpectralStreamReader::schedule(size_t block)
+    {
+        if (block >= _nBlocks) {
+            return;
+        }
+
+        // Blocks share the channel reader: each one is decoded after
+        // the previous one
+        const std::shared_future<void> previous = _lastRead;
+
+        _lastRead = std::async(std::launch::async, [this, block, previous]() {
+                        if (previous.valid()) {
+                            previous.wait();
+                        }
+
+                        read(block);
+                    }).share();
+
+        _reads[block % _blocks.size()] = _lastRead;
+    }
+
+
+    void EXRSpectralStreamReader::read(size_t block)
+    {
+        Block &b = _blocks[block % _blocks.size()];
+
+        const int y0 = std::max(_firstBlockY + int(block * _blockRows), _minY);
+        const int y1 = std::min(
+          _firstBlockY + int((block + 1) * _blockRows) - 1,
+          _maxY);
+
+        b._y     = y0 - _minY;
+        b._nRows = y1 - y0 + 1;
+
+        _reader->clearChannels();
+        _reader->setRegion(Imath::Box2i(
+          Imath::V2i(_minX, y0),
+          Imath::V2i(_minX + int(_width) - 1, y1)));
+
+        const size_t xStride = sizeof(float) * nSpectralBands();
+        const size_t yStride = xStride * _width;
+
+        for (size_t s = 0; s < nStokesComponents(); s++) {
+            for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
+                const Channel &channel = _emissiveChannels[s][wl_idx];
+
+                _reader->addChannel(
+                  channel.name,
+                  &b._emissive[s][wl_idx],
+                  xStride,
+                  yStride,
+                  channel.scale,
+                  channel.offset);
+            }
+        }
+
+        for (size_t wl_idx = 0; wl_idx < _reflectiveChannels.size(); wl_idx++) {
+            const Channel &channel = _reflectiveChannels[wl_idx];
+
+            _reader->addChannel(
+              channel.name,
+              &b._reflective[wl_idx],
+              xStride,
+              yStride,
+              channel.scale,
+              channel.offset);
+        }
+
+        _reader->read();
+    }
+
+}   // namespace SEXR
@@ -0,0 +1,301 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <EXRSpectralStreamWriter.h>
+#include <EXRSpectralImage.h>
+#include <Threading.h>
+#include "EXRChannelWriter.h"
+#include "SpectrumConverter.h"
+#include "SpectrumConverterCache.h"
+
+#include <cmath>
+
+#include <OpenEXR/ImfStandardAttributes.h>
+
+namespace SEXR
+{
+    EXRSpectralStreamWriter::EXRSpectralStreamWriter(
+      const std::string &       filename,
+      size_t                    width,
+      size_t                    height,
+      const std::vector<float> &wavelengths_nm,
+      SpectrumType              type,
+      const Metadata &          metadata,
+      const SaveOptions &       options)
+      : _writer(new EXRChannelWriter(width, height))
+      , _width(width)
+      , _height(height)
+      , _spectrumType(type)
+      , _wavelengths_nm(wavelengths_nm)
+      , _exposure(std::pow(2.F, metadata.ev))
+    {
+        // The reradiation is not streamed
+        if (
+          width == 0 || height == 0 || wavelengths_nm.empty()
+          || isBispectralSpectrum(type)
+          || (!isEmissive() && !isReflective())) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        // HALF scales are computed from the whole image
+        if (
+          isEmissive() && options.emissiveType == Imf::HALF
+          && options.scaleEmissive) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        if (
+          !metadata.channelSensitivities.empty()
+          && metadata.channelSensitivities.size() != nSpectralBands()) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        if (
+          metadata.observer >= Colorimetry::nObservers()
+          || metadata.illuminant >= Colorimetry::nIlluminants()) {
+            throw Colorimetry::INVALID_INDEX;
+        }
+
+        SpectrumType convertedType = UNDEFINED;
+
+        if (isEmissive()) {
+            convertedType = convertedType | EMISSIVE;
+        }
+
+        if (isReflective()) {
+            convertedType = convertedType | REFLECTIVE;
+        }
+
+        _converter = SpectrumConverterCache::get(
+          _wavelengths_nm,
+          convertedType,
+          metadata.observer,
+          metadata.illuminant);
+
+        // ---------------------------------------------------------------------
+        // Declare the channels, their rows are given by writeRows()
+        // ---------------------------------------------------------------------
+
+        const std::array<std::string, 3> rgbChannels = {"R", "G", "B"};
+        const size_t                     xStrideRGB  = sizeof(float) * 3;
+        const size_t                     yStrideRGB  = xStrideRGB * width;
+
+        for (size_t c = 0; c < 3; c++) {
+            _writer->addChannel(
+              rgbChannels[c],
+              nullptr,
+              xStrideRGB,
+              yStrideRGB);
+        }
+
+        const size_t xStride = sizeof(float) * nSpectralBands();
+        const size_t yStride = xStride * width;
+
+        for (size_t s = 0; s < nStokesComponents(); s++) {
+            for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
+                _writer->addChannel(
+                  EXRSpectralImage::getEmissiveChannelName(
+                    s,
+                    _wavelengths_nm[wl_idx]),
+                  nullptr,
+                  xStride,
+                  yStride,
+                  options.emissiveType);
+            }
+        }
+
+        if (isReflective()) {
+            for (size_t wl_idx = 0; wl_idx < nSpectralBands(); wl_idx++) {
+                _writer->addChannel(
+                  EXRSpectralImage::getReflectiveChannelName(
+                    _wavelengths_nm[wl_idx]),
+                  nullptr,
+                  xStride,
+                  yStride,
+                  options.reflectiveType);
+            }
+        }
+
+        // ---------------------------------------------------------------------
+        // Write metadata
+        // ---------------------------------------------------------------------
+
+        Imf::Header &exrHeader = _writer->header();
+
+        exrHeader.insert(
+          EXRSpectralImage::VERSION_ATTR,
+          Imf::StringAttribute("1.0"));
+
+        if (metadata.lensTransmission.size() > 0) {
+            exrHeader.insert(
+              EXRSpectralImage::LENS_TRANSMISSION_ATTR,
+              metadata.lensTransmission.getAttribute());
+        }
+
+        if (metadata.cameraResponse.size() > 0) {
+            exrHeader.insert(
+              EXRSpectralImage::CAMERA_RESPONSE_ATTR,
+              metadata.cameraResponse.getAttribute());
+        }
+
+        for (size_t wl_idx = 0; wl_idx < metadata.channelSensitivities.size();
+             wl_idx++) {
+            if (metadata.channelSensitivities[wl_idx].size() > 0) {
+                exrHeader.insert(
+                  EXRSpectralImage::getEmissiveChannelName(
+                    0,
+                    _wavelengths_nm[wl_idx]),
+                  metadata.channelSensitivities[wl_idx].getAttribute());
+            }
+        }
+
+        exrHeader.insert(
+          EXRSpectralImage::EXPOSURE_COMPENSATION_ATTR,
+          Imf::FloatAttribute(metadata.ev));
+
+        if (isEmissive()) {
+            exrHeader.insert(
+              EXRSpectralImage::EMISSIVE_UNITS_ATTR,
+              Imf::StringAttribute("W.m^-2.sr^-1"));
+        }
+
+        if (isPolarised()) {
+            exrHeader.insert(
+              EXRSpectralImage::POLARISATION_HANDEDNESS_ATTR,
+              Imf::StringAttribute(
+                metadata.handedness == SpectralImage::LEFT_HANDED ? "left"
+                                                                  : "right"));
+        }
+
+        // Throws on quantised values, tiles or parts
+        _writer->open(filename, options);
+    }
+
+
+    EXRSpectralStreamWriter::~EXRSpectralStreamWriter() {}
+
+
+    size_t EXRSpectralStreamWriter::nextRow() const
+    {
+        return _writer->nextRow();
+    }
+
+
+    void EXRSpectralStreamWriter::writeRows(
+      size_t                              nRows,
+      const std::array<const float *, 4> &emissive,
+      const float *                       reflective)
+    {
+        for (size_t s = 0; s < nStokesComponents(); s++) {
+            if (emissive[s] == nullptr) {
+                throw SpectralImage::INVALID_OPTIONS;
+            }
+        }
+
+        if (
+          (isReflective() && reflective == nullptr)
+          || nRows > _height - nextRow()) {
+            throw SpectralImage::INVALID_OPTIONS;
+        }
+
+        if (nRows == 0) {
+            return;
+        }
+
+        // ---------------------------------------------------------------------
+        // Compute the RGB preview of the rows
+        // ---------------------------------------------------------------------
+
+        const SpectrumConverter &sc     = *_converter;
+        const size_t             nBands = nSpectralBands();
+
+        _rgb.resize(3 * _width * nRows);
+
+        const int nThreads = static_cast<int>(Threading::threadCount());
+
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads)
+        for (int row = 0; row < int(nRows); row++) {
+            const size_t i   = row * _width;
+            float *      rgb = &_rgb[3 * i];
+
+            if (isEmissive() && isReflective()) {
+                sc.spectraToRGBBatch(
+                  &reflective[nBands * i],
+                  &emissive[0][nBands * i],
+                  _width,
+                  rgb,
+                  _exposure);
+            } else if (isEmissive()) {
+                sc.spectrumToRGBBatch(
+                  &emissive[0][nBands * i],
+                  _width,
+                  rgb,
+                  _exposure);
+            } else {
+                sc.spectrumToRGBBatch(
+                  &reflective[nBands * i],
+                  _width,
+                  rgb,
+                  _exposure);
+            }
+        }
+
+        // ---------------------------------------------------------------------
+        // Write the rows, in the order of the channels
+        // ---------------------------------------------------------------------
+
+        std::vector<const float *> rows;
+
+        for (size_t c = 0; c < 3; c++) {
+            rows.push_back(&_rgb[c]);
+        }
+
+        for (size_t s = 0; s < nStokesComponents(); s++) {
+            for (size_t wl_idx = 0; wl_idx < nBands; wl_idx++) {
+                rows.push_back(&emissive[s][wl_idx]);
+            }
+        }
+
+        if (isReflective()) {
+            for (size_t wl_idx = 0; wl_idx < nBands; wl_idx++) {
+                rows.push_back(&reflective[wl_idx]);
+            }
+        }
+
+        _writer->writeRows(nRows, rows);
+    }
+
+}   // namespace SEXR
@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "HalfConversion.h"
+#include "CpuFeatures.h"
+
+#include <cstring>
+
+namespace SEXR
+{
+    static inline float halfToFloat(uint16_t h)
+    {
+        const uint32_t sign     = uint32_t(h & 0x8000) << 16;
+        const uint32_t exponent = (h >> 10) & 0x1f;
+        const uint32_t mantissa = h & 0x3ff;
+
+        uint32_t bits;
+
+        if (exponent == 0x1f) {
+            // Infinity or NaN
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        } else if (exponent != 0) {
+            // Normal: rebias the exponent from 15 to 127
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        } else {
+            // Zero or subnormal: mantissa * 2^-24 is exact in float
+            const float value = float(mantissa) * 5.9604644775390625e-8F;
+            memcpy(&bits, &value, sizeof(float));
+            bits |= sign;
+        }
+
+        float f;
+        memcpy(&f, &bits, sizeof(float));
+
+        return f;
+    }
+
+
+    static void scalarToFloat(
+      const uint16_t *src, size_t n, float scale, float *dst)
+    {
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = halfToFloat(src[i]) * scale;
+        }
+    }
+
+
+#ifdef SEXR_X86_KERNELS
+    SEXR_TARGET("avx,f16c")
+    static void f16cToFloat(
+      const uint16_t *src, size_t n, float scale, float *dst)
+    {
+        const __m256 s = _mm256_set1_ps(scale);
+        size_t       i = 0;
+
+        for (; i + 8 <= n; i += 8) {
+            const __m128i h = _mm_loadu_si128((const __m128i *)&src[i]);
+            _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_cvtph_ps(h), s));
+        }
+
+        scalarToFloat(&src[i], n - i, scale, &dst[i]);
+    }
+#endif   // SEXR_X86_KERNELS
+
+
+#ifdef SEXR_NEON_KERNELS
+    // NEON and its half conversions are always available on AArch64
+    static void neonToFloat(
+      const uint16_t *src, size_t n, float scale, float *dst)
+    {
+        const float32x4_t s = vdupq_n_f32(scale);
+        size_t            i = 0;
+
+        for (; i + 8 <= n; i += 8) {
+            const float16x8_t h = vreinterpretq_f16_u16(vld1q_u16(&src[i]));
+            vst1q_f32(&dst[i], vmulq_f32(vcvt_f32_f16(vget_low_f16(h)), s));
+            vst1q_f32(&dst[i + 4], vmulq_f32(vcvt_high_f32_f16(h), s));
+        }
+
+        scalarToFloat(&src[i], n - i, scale, &dst[i]);
+    }
+#endif   // SEXR_NEON_KERNELS
+
+
+    typedef void (*ToFloatKernel)(
+      const uint16_t *src, size_t n, float scale, float *dst);
+
+
+    static ToFloatKernel selectedKernel()
+    {
+#if defined(SEXR_NEON_KERNELS)
+        return neonToFloat;
+#elif defined(SEXR_X86_KERNELS)
+        static const ToFloatKernel kernel
+          = CpuFeatures::hasF16C() ? f16cToFloat : scalarToFloat;
+        return kernel;
+#else
+        return scalarToFloat;
+#endif
+    }
+
+
+    void HalfConversion::toFloat(
+      const uint16_t *src, size_t n, float scale, float *dst)
+    {
+        selectedKernel()(src, n, scale, dst);
+    }
+
+
+    const char *HalfConversion::kernelName()
+    {
+#if defined(SEXR_NEON_KERNELS)
+        return "NEON";
+#elif defined(SEXR_X86_KERNELS)
+        return selectedKernel() == f16cToFloat ? "F16C" : "scalar";
+#else
+        return "scalar";
+#endif
+    }
+
+}   // namespace SEXR
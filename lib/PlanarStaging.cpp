@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PlanarStaging.h"
+
+#include <Threading.h>
+
+namespace SEXR
+{
+    constexpr size_t PlanarStaging::TILE_SIZE;
+    constexpr size_t PlanarStaging::CACHE_LINE;
+    constexpr size_t PlanarStaging::BUDGET;
+
+
+    int PlanarStaging::linesPerBlock(Imf::Compression compression)
+    {
+        switch (compression) {
+            case Imf::ZIP_COMPRESSION:
+            case Imf::PXR24_COMPRESSION:
+                return 16;
+
+            case Imf::PIZ_COMPRESSION:
+            case Imf::B44_COMPRESSION:
+            case Imf::B44A_COMPRESSION:
+            case Imf::DWAA_COMPRESSION:
+                return 32;
+
+            case Imf::DWAB_COMPRESSION:
+                return 256;
+
+            default:
+                return 1;
+        }
+    }
+
+
+    int PlanarStaging::chunkLines(int blockLines, size_t bytesPerLine)
+    {
+        // Blocks of a single line are grouped by 16 at least
+        const size_t nBlocks = std::max(
+          Threading::threadCount(),
+          size_t(std::max(1, 16 / blockLines)));
+
+        const size_t budgetBlocks
+          = BUDGET / std::max(bytesPerLine * blockLines, size_t(1));
+
+        return blockLines
+               * int(std::max(std::min(nBlocks, budgetBlocks), size_t(1)));
+    }
+
+
+    void PlanarStaging::toInterleaved(
+      const float *const *planes,
+      size_t              nChannels,
+      size_t              nPixels,
+      float *             pixels,
+      size_t              pixelStride)
+    {
+        for (size_t x0 = 0; x0 < nPixels; x0 += TILE_SIZE) {
+            const size_t x1 = std::min(x0 + TILE_SIZE, nPixels);
+
+            for (size_t c0 = 0; c0 < nChannels; c0 += TILE_SIZE) {
+                const size_t c1 = std::min(c0 + TILE_SIZE, nChannels);
+
+                for (size_t x = x0; x < x1; x++) {
+                    float *pixel = pixels + x * pixelStride;
+
+                    for (size_t c = c0; c < c1; c++) {
+                        pixel[c] = planes[c][x];
+                    }
+                }
+            }
+        }
+    }
+
+
+    void PlanarStaging::toPlanar(
+      const float * pixels,
+      size_t        pixelStride,
+      size_t        nChannels,
+      size_t        nPixels,
+      float *const *planes)
+    {
+        for (size_t c0 = 0; c0 < nChannels; c0 += TILE_SIZE) {
+            const size_t c1 = std::min(c0 + TILE_SIZE, nChannels);
+
+            for (size_t x0 = 0; x0 < nPixels; x0 += TILE_SIZE) {
+                const size_t x1 = std::min(x0 + TILE_SIZE, nPixels);
+
+                for (size_t c = c0; c < c1; c++) {
+                    float *plane = planes[c];
+
+                    for (size_t x = x0; x < x1; x++) {
+                        plane[x] = pixels[x * pixelStride + c];
+                    }
+                }
+            }
+        }
+    }
+
+}   // namespace SEXR
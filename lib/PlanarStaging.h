@@ -0,0 +1,209 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <OpenEXR/ImfCompression.h>
+
+namespace SEXR
+{
+    /**
+     * Moves channels between interleaved pixel buffers and planar
+     * staging buffers, which OpenEXR reads and writes with a unit
+     * stride. Slices pointing to interleaved buffers with hundreds of
+     * channels make OpenEXR touch a new cache line and often a new
+     * page for every value; the transposes instead go through tiles
+     * of TILE_SIZE pixels by TILE_SIZE channels that fit in the L1
+     * cache.
+     */
+    class PlanarStaging
+    {
+      public:
+        /** How the pixels are handed to OpenEXR. */
+        enum Transfer
+        {
+            AUTOMATIC,   // Staged when the pixels are wider than a cache line
+            DIRECT,      // Slices point to the pixel buffers when possible
+            STAGED       // Always through planar staging buffers
+        };
+
+        static constexpr size_t TILE_SIZE  = 32;
+        static constexpr size_t CACHE_LINE = 64;
+
+        /** Size targeted for the staging buffers, in bytes. */
+        static constexpr size_t BUDGET = size_t(32) << 20;
+
+        /**
+         * Whether a channel of a buffer is staged.
+         *
+         * @param transfer requested transfer.
+         * @param xStride offset in bytes between two pixels.
+         */
+        static bool isStaged(Transfer transfer, size_t xStride)
+        {
+            if (xStride == sizeof(float)) {
+                return false;
+            }
+
+            switch (transfer) {
+                case AUTOMATIC: return xStride > CACHE_LINE;
+                case STAGED: return true;
+                default: return false;
+            }
+        }
+
+        /**
+         * Groups the channels into runs of consecutive floats of the
+         * same interleaved buffer, sorted by address. A run is moved
+         * by a single transpose.
+         *
+         * @param channels channels with base, xStride and yStride
+         * members.
+         * @param staged whether a channel is staged, the others are
+         * not in any run.
+         *
+         * @returns the indices of the channels of each run.
+         */
+        template<typename Channel, typename Filter>
+        static std::vector<std::vector<size_t>>
+        runs(const std::vector<Channel> &channels, Filter staged)
+        {
+            std::vector<size_t> order;
+
+            for (size_t c = 0; c < channels.size(); c++) {
+                if (staged(channels[c])) {
+                    order.push_back(c);
+                }
+            }
+
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return std::less<const char *>()(
+                  channels[a].base,
+                  channels[b].base);
+            });
+
+            std::vector<std::vector<size_t>> result;
+
+            for (size_t c : order) {
+                if (!result.empty()) {
+                    const Channel &curr = channels[c];
+                    const Channel &prev = channels[result.back().back()];
+
+                    if (
+                      curr.base == prev.base + sizeof(float)
+                      && curr.xStride == prev.xStride
+                      && curr.yStride == prev.yStride) {
+                        result.back().push_back(c);
+                        continue;
+                    }
+                }
+
+                result.push_back(std::vector<size_t>(1, c));
+            }
+
+            return result;
+        }
+
+        /** Number of channels of the runs. */
+        static size_t
+        nChannels(const std::vector<std::vector<size_t>> &channelRuns)
+        {
+            size_t n = 0;
+
+            for (const std::vector<size_t> &run : channelRuns) {
+                n += run.size();
+            }
+
+            return n;
+        }
+
+        /**
+         * Number of scanlines compressed together by a compression
+         * method.
+         */
+        static int linesPerBlock(Imf::Compression compression);
+
+        /**
+         * Number of lines to stage at once: enough blocks for every
+         * OpenEXR thread to work on one, within BUDGET, and at least
+         * a block.
+         *
+         * @param blockLines number of lines of a block.
+         * @param bytesPerLine size of a staged line.
+         */
+        static int chunkLines(int blockLines, size_t bytesPerLine);
+
+        /**
+         * Copies planes to interleaved pixels.
+         *
+         * @param planes nChannels planes of nPixels values.
+         * @param nChannels number of channels.
+         * @param nPixels number of pixels.
+         * @param pixels receives the channel c of the pixel x at
+         * pixels[x * pixelStride + c].
+         * @param pixelStride number of floats between two pixels.
+         */
+        static void toInterleaved(
+          const float *const *planes,
+          size_t              nChannels,
+          size_t              nPixels,
+          float *             pixels,
+          size_t              pixelStride);
+
+        /**
+         * Copies interleaved pixels to planes.
+         *
+         * @param pixels channel c of the pixel x is read at
+         * pixels[x * pixelStride + c].
+         * @param pixelStride number of floats between two pixels.
+         * @param nChannels number of channels.
+         * @param nPixels number of pixels.
+         * @param planes nChannels planes receiving nPixels values.
+         */
+        static void toPlanar(
+          const float * pixels,
+          size_t        pixelStride,
+          size_t        nChannels,
+          size_t        nPixels,
+          float *const *planes);
+    };
+
+}   // namespace SEXR
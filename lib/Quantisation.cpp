@@ -0,0 +1,254 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Quantisation.h"
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SEXR
+{
+    constexpr uint32_t Quantisation::MAX_LEVEL;
+
+
+    // The SIMD kernels round to nearest even and clamp the same way
+    static void scalarQuantise(
+      const float *src, size_t n, float scale, float offset, uint32_t *dst)
+    {
+        const float maxLevel = float(Quantisation::MAX_LEVEL);
+
+        for (size_t i = 0; i < n; i++) {
+            float level = std::nearbyint((src[i] - offset) / scale);
+
+            // Also sends NaN to 0
+            level  = level > 0.F ? level : 0.F;
+            level  = level < maxLevel ? level : maxLevel;
+            dst[i] = uint32_t(level);
+        }
+    }
+
+
+    static void scalarDequantise(
+      const uint32_t *src, size_t n, float scale, float offset, float *dst)
+    {
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = offset + float(src[i]) * scale;
+        }
+    }
+
+
+#ifdef SEXR_X86_KERNELS
+    SEXR_TARGET("avx2")
+    static void avx2Quantise(
+      const float *src, size_t n, float scale, float offset, uint32_t *dst)
+    {
+        const __m256 s        = _mm256_set1_ps(scale);
+        const __m256 o        = _mm256_set1_ps(offset);
+        const __m256 maxLevel
+          = _mm256_set1_ps(float(Quantisation::MAX_LEVEL));
+        size_t       i        = 0;
+
+        for (; i + 8 <= n; i += 8) {
+            const __m256 v = _mm256_loadu_ps(&src[i]);
+
+            __m256 level = _mm256_div_ps(_mm256_sub_ps(v, o), s);
+            level        = _mm256_round_ps(
+              level,
+              _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+            // max returns its second operand for NaN
+            level = _mm256_max_ps(level, _mm256_setzero_ps());
+            level = _mm256_min_ps(level, maxLevel);
+
+            _mm256_storeu_si256(
+              (__m256i *)&dst[i],
+              _mm256_cvtps_epi32(level));
+        }
+
+        scalarQuantise(&src[i], n - i, scale, offset, &dst[i]);
+    }
+
+
+    SEXR_TARGET("avx2")
+    static void avx2Dequantise(
+      const uint32_t *src, size_t n, float scale, float offset, float *dst)
+    {
+        const __m256  s     = _mm256_set1_ps(scale);
+        const __m256  o     = _mm256_set1_ps(offset);
+        const __m256i low16 = _mm256_set1_epi32(0xffff);
+        size_t        i     = 0;
+
+        for (; i + 8 <= n; i += 8) {
+            const __m256i u = _mm256_loadu_si256((const __m256i *)&src[i]);
+
+            // Converts as unsigned: both halves are exact, the sum is
+            // rounded once like the scalar conversion
+            const __m256 high = _mm256_cvtepi32_ps(_mm256_srli_epi32(u, 16));
+            const __m256 low  = _mm256_cvtepi32_ps(_mm256_and_si256(u, low16));
+            const __m256 value = _mm256_add_ps(
+              _mm256_mul_ps(high, _mm256_set1_ps(65536.F)),
+              low);
+
+            _mm256_storeu_ps(
+              &dst[i],
+              _mm256_add_ps(o, _mm256_mul_ps(value, s)));
+        }
+
+        scalarDequantise(&src[i], n - i, scale, offset, &dst[i]);
+    }
+#endif   // SEXR_X86_KERNELS
+
+
+#ifdef SEXR_NEON_KERNELS
+    static void neonQuantise(
+      const float *src, size_t n, float scale, float offset, uint32_t *dst)
+    {
+        const float32x4_t s        = vdupq_n_f32(scale);
+        const float32x4_t o        = vdupq_n_f32(offset);
+        const float32x4_t maxLevel
+          = vdupq_n_f32(float(Quantisation::MAX_LEVEL));
+        size_t            i        = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            float32x4_t level
+              = vrndnq_f32(vdivq_f32(vsubq_f32(vld1q_f32(&src[i]), o), s));
+
+            // maxnm returns the number for NaN
+            level = vmaxnmq_f32(level, vdupq_n_f32(0.F));
+            level = vminq_f32(level, maxLevel);
+
+            vst1q_u32(&dst[i], vcvtq_u32_f32(level));
+        }
+
+        scalarQuantise(&src[i], n - i, scale, offset, &dst[i]);
+    }
+
+
+    static void neonDequantise(
+      const uint32_t *src, size_t n, float scale, float offset, float *dst)
+    {
+        const float32x4_t s = vdupq_n_f32(scale);
+        const float32x4_t o = vdupq_n_f32(offset);
+        size_t            i = 0;
+
+        for (; i + 4 <= n; i += 4) {
+            const float32x4_t value = vcvtq_f32_u32(vld1q_u32(&src[i]));
+            vst1q_f32(&dst[i], vaddq_f32(o, vmulq_f32(value, s)));
+        }
+
+        scalarDequantise(&src[i], n - i, scale, offset, &dst[i]);
+    }
+#endif   // SEXR_NEON_KERNELS
+
+
+    void Quantisation::range(
+      const float *values, size_t n, float &scale, float &offset)
+    {
+        float minValue = INFINITY;
+        float maxValue = -INFINITY;
+
+        for (size_t i = 0; i < n; i++) {
+            if (std::isfinite(values[i])) {
+                minValue = std::min(minValue, values[i]);
+                maxValue = std::max(maxValue, values[i]);
+            }
+        }
+
+        if (minValue > maxValue) {
+            // No finite value
+            scale  = 1.F;
+            offset = 0.F;
+            return;
+        }
+
+        // Divided first so the difference cannot overflow
+        offset = minValue;
+        scale  = maxValue / float(MAX_LEVEL) - minValue / float(MAX_LEVEL);
+
+        if (scale == 0.F) {
+            // Constant values, all stored as level 0
+            scale = 1.F;
+        }
+    }
+
+
+    void Quantisation::quantise(
+      const float *src, size_t n, float scale, float offset, uint32_t *dst)
+    {
+#if defined(SEXR_NEON_KERNELS)
+        neonQuantise(src, n, scale, offset, dst);
+#elif defined(SEXR_X86_KERNELS)
+        if (CpuFeatures::hasAVX2()) {
+            avx2Quantise(src, n, scale, offset, dst);
+        } else {
+            scalarQuantise(src, n, scale, offset, dst);
+        }
+#else
+        scalarQuantise(src, n, scale, offset, dst);
+#endif
+    }
+
+
+    void Quantisation::dequantise(
+      const uint32_t *src, size_t n, float scale, float offset, float *dst)
+    {
+#if defined(SEXR_NEON_KERNELS)
+        neonDequantise(src, n, scale, offset, dst);
+#elif defined(SEXR_X86_KERNELS)
+        if (CpuFeatures::hasAVX2()) {
+            avx2Dequantise(src, n, scale, offset, dst);
+        } else {
+            scalarDequantise(src, n, scale, offset, dst);
+        }
+#else
+        scalarDequantise(src, n, scale, offset, dst);
+#endif
+    }
+
+
+    const char *Quantisation::kernelName()
+    {
+#if defined(SEXR_NEON_KERNELS)
+        return "NEON";
+#elif defined(SEXR_X86_KERNELS)
+        return CpuFeatures::hasAVX2() ? "AVX2" : "scalar";
+#else
+        return "scalar";
+#endif
+    }
+
+}   // namespace SEXR
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SEXR
+{
+    /**
+     * Quantisation of bounded values to 16-bit integers stored in UINT
+     * channels: a value v is stored as round((v - offset) / scale),
+     * clamped to [0, MAX_LEVEL]. The conversions use AVX2 when the
+     * running CPU supports it and NEON on AArch64.
+     */
+    class Quantisation
+    {
+      public:
+        static constexpr uint32_t MAX_LEVEL = 65535;
+
+        /**
+         * Computes the scale and the offset mapping the range of
+         * values to [0, MAX_LEVEL]. Non finite values are ignored.
+         *
+         * @param values values to quantise.
+         * @param n number of values.
+         * @param scale receives the size of a quantisation step.
+         * @param offset receives the value of the level 0.
+         */
+        static void
+        range(const float *values, size_t n, float &scale, float &offset);
+
+        /**
+         * Quantises values. NaN are stored as 0.
+         *
+         * @param src n values.
+         * @param n number of values.
+         * @param scale size of a quantisation step.
+         * @param offset value of the level 0.
+         * @param dst receives the n quantised values.
+         */
+        static void quantise(
+          const float *src, size_t n, float scale, float offset, uint32_t *dst);
+
+        /**
+         * Converts quantised values back to floats, as
+         * offset + level * scale.
+         *
+         * @param src n quantised values.
+         * @param n number of values.
+         * @param scale size of a quantisation step.
+         * @param offset value of the level 0.
+         * @param dst receives the n values.
+         */
+        static void dequantise(
+          const uint32_t *src, size_t n, float scale, float offset, float *dst);
+
+        /** Gets the name of the instruction set the conversions use. */
+        static const char *kernelName();
+    };
+
+}   // namespace SEXR
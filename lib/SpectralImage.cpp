@@ -35,17 +35,21 @@
  */
 
 #include <SpectralImage.h>
+#include <Threading.h>
 
+#include <algorithm>
 #include <sstream>
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <functional>
 
 #include <OpenEXR/ImfOutputFile.h>
 #include <OpenEXR/ImfChannelList.h>
 #include <OpenEXR/ImfFrameBuffer.h>
 
-#include "SpectrumConverter.h"
+#include "SpectrumConverterCache.h"
+#include "SpectrumMemo.h"
 
 namespace SEXR
 {
@@ -58,6 +62,8 @@ namespace SEXR
       : _width(width)
       , _height(height)
       , _ev(0)
+      , _observer(Colorimetry::OBSERVER_CIE1931_2DEG)
+      , _illuminant(Colorimetry::ILLUMINANT_D65)
       , _wavelengths_nm(wavelengths_nm)
       , _spectrumType(type)
       , _polarisationHandedness(handedness)
@@ -73,6 +79,8 @@ namespace SEXR
         }
 
         _channelSensitivities.resize(nSpectralBands());
+
+        invalidatePreview();
     }
 
 
@@ -93,7 +101,10 @@ namespace SEXR
                   "Y",
                   Imf::Slice(Imf::FLOAT, (char *)(buffer), xStride, yStride));
 
-                Imf::OutputFile exrOut(filename.c_str(), exrHeader);
+                Imf::OutputFile exrOut(
+                  filename.c_str(),
+                  exrHeader,
+                  Threading::openEXRThreadCount());
                 exrOut.setFrameBuffer(exrFrameBuffer);
                 exrOut.writePixels(height());
             };
@@ -127,47 +138,482 @@ namespace SEXR
     }
 
 
+    const size_t SpectralImage::PREVIEW_TILE_SIZE;
+
+
     void SpectralImage::getRGBImage(std::vector<float> &rgbImage) const
     {
-        rgbImage.resize(3 * width() * height());
-        SpectrumConverter sc(isEmissive());
+        std::lock_guard<std::mutex> lock(_preview.mutex);
 
-        std::array<float, 3> rgb;
+        if (_preview.rgb.size() != 3 * width() * height()
+            || _preview.dirty.size() != previewTilesX() * previewTilesY()) {
+            invalidatePreview();
+        }
 
-        if (isEmissive() && isReflective()) {
-            for (size_t i = 0; i < width() * height(); i++) {
-                sc.spectraToRGB(
-                  _wavelengths_nm,
-                  &_reflectivePixelBuffer[nSpectralBands() * i],
-                  &_emissivePixelBuffers[0][nSpectralBands() * i],
-                  rgb);
-
-                memcpy(&rgbImage[3 * i], &rgb[0], 3 * sizeof(float));
+        // Flags are cleared before the conversion so a tile modified
+        // meanwhile is converted again on the next call
+        std::vector<size_t> dirtyTiles;
+
+        for (size_t t = 0; t < _preview.dirty.size(); t++) {
+            if (_preview.dirty[t].exchange(0, std::memory_order_relaxed)) {
+                dirtyTiles.push_back(t);
             }
-        } else if (isEmissive()) {
-            for (size_t i = 0; i < width() * height(); i++) {
-                sc.spectrumToRGB(
-                  _wavelengths_nm,
-                  &_emissivePixelBuffers[0][nSpectralBands() * i],
-                  rgb);
+        }
+
+        if (!dirtyTiles.empty()) {
+            std::shared_ptr<const SpectrumConverter> sc
+              = SpectrumConverterCache::get(
+                _wavelengths_nm,
+                rgbConversionType(),
+                _observer,
+                _illuminant);
+
+            if (_preview.memoBudget > 0 && !_preview.memo) {
+                const float *data[SpectrumMemo::MAX_COMPONENTS];
+                size_t       sizes[SpectrumMemo::MAX_COMPONENTS];
+                size_t       keySize = 0;
 
-                memcpy(&rgbImage[3 * i], &rgb[0], 3 * sizeof(float));
+                const size_t nComponents = pixelComponents(0, 0, data, sizes);
+
+                for (size_t c = 0; c < nComponents; c++) {
+                    keySize += sizes[c];
+                }
+
+                _preview.memo.reset(
+                  new SpectrumMemo(keySize, _preview.memoBudget));
+            }
+
+            SpectrumMemo *memo = _preview.memo.get();
+
+            const size_t tilesX   = previewTilesX();
+            const int    nTiles   = static_cast<int>(dirtyTiles.size());
+            const int    nThreads = static_cast<int>(Threading::threadCount());
+
+            // Tiles are independent: each thread picks the next tile
+            // to convert so the output is the same as a serial conversion
+#pragma omp parallel num_threads(nThreads)
+            {
+                // Hashes of the memoised spans, reused across tiles
+                std::vector<uint64_t> hashes;
+
+#pragma omp for schedule(dynamic)
+                for (int t = 0; t < nTiles; t++) {
+                    const size_t x0
+                      = (dirtyTiles[t] % tilesX) * PREVIEW_TILE_SIZE;
+                    const size_t y0
+                      = (dirtyTiles[t] / tilesX) * PREVIEW_TILE_SIZE;
+                    const size_t x1 = std::min(x0 + PREVIEW_TILE_SIZE, width());
+                    const size_t y1
+                      = std::min(y0 + PREVIEW_TILE_SIZE, height());
+
+                    for (size_t y = y0; y < y1; y++) {
+                        float *rgb = &_preview.rgb[3 * (y * width() + x0)];
+
+                        if (memo) {
+                            convertRGBSpanMemoised(
+                              *sc,
+                              *memo,
+                              x0,
+                              y,
+                              x1 - x0,
+                              rgb,
+                              hashes);
+                        } else {
+                            convertRGBSpan(*sc, x0, y, x1 - x0, rgb);
+                        }
+                    }
+                }
+            }
+        }
+
+        // The exposure compensation is a scale so it is applied to
+        // the cached version rather than invalidating it
+        const float exposure = std::pow(2.F, _ev);
+
+        if (exposure == 1.F) {
+            rgbImage = _preview.rgb;
+        } else {
+            rgbImage.resize(_preview.rgb.size());
+
+            for (size_t i = 0; i < rgbImage.size(); i++) {
+                rgbImage[i] = exposure * _preview.rgb[i];
             }
+        }
+    }
+
+
+    void SpectralImage::convertRGBSpan(
+      const SpectrumConverter &sc,
+      size_t                   x,
+      size_t                   y,
+      size_t                   n,
+      float *                  rgb) const
+    {
+        const size_t i = y * width() + x;
+
+        if (isEmissive() && isReflective()) {
+            sc.spectraToRGBBatch(
+              &_reflectivePixelBuffer[nSpectralBands() * i],
+              &_emissivePixelBuffers[0][nSpectralBands() * i],
+              n,
+              rgb);
+        } else if (isEmissive()) {
+            sc.spectrumToRGBBatch(
+              &_emissivePixelBuffers[0][nSpectralBands() * i],
+              n,
+              rgb);
         } else if (isReflective()) {
-            for (size_t i = 0; i < width() * height(); i++) {
-                sc.spectrumToRGB(
-                  _wavelengths_nm,
-                  &_reflectivePixelBuffer[nSpectralBands() * i],
-                  rgb);
+            sc.spectrumToRGBBatch(
+              &_reflectivePixelBuffer[nSpectralBands() * i],
+              n,
+              rgb);
+        } else {
+            std::fill(rgb, rgb + 3 * n, 0.F);
+        }
+    }
+
+
+    void SpectralImage::convertXYZSpan(
+      const SpectrumConverter &sc,
+      size_t                   x,
+      size_t                   y,
+      size_t                   n,
+      float *                  xyz,
+      float                    scale) const
+    {
+        const size_t i = y * width() + x;
+
+        if (isEmissive() && isReflective()) {
+            sc.spectraToXYZBatch(
+              &_reflectivePixelBuffer[nSpectralBands() * i],
+              &_emissivePixelBuffers[0][nSpectralBands() * i],
+              n,
+              xyz,
+              scale);
+        } else if (isEmissive()) {
+            sc.spectrumToXYZBatch(
+              &_emissivePixelBuffers[0][nSpectralBands() * i],
+              n,
+              xyz,
+              scale);
+        } else if (isReflective()) {
+            sc.spectrumToXYZBatch(
+              &_reflectivePixelBuffer[nSpectralBands() * i],
+              n,
+              xyz,
+              scale);
+        } else {
+            std::fill(xyz, xyz + 3 * n, 0.F);
+        }
+    }
+
 
-                memcpy(&rgbImage[3 * i], &rgb[0], 3 * sizeof(float));
+    void SpectralImage::convertRGBSpanMemoised(
+      const SpectrumConverter &sc,
+      SpectrumMemo &           memo,
+      size_t                   x,
+      size_t                   y,
+      size_t                   n,
+      float *                  rgb,
+      std::vector<uint64_t> &  hashes) const
+    {
+        SpectrumMemo::Pixel previous;
+        SpectrumMemo::Pixel current;
+        size_t              hits    = 0;
+        size_t              pending = n;
+
+        hashes.resize(n);
+
+        // Consecutive misses are converted with a single batch, then
+        // memoised
+        auto flush = [&](size_t end) {
+            if (pending >= end) {
+                return;
+            }
+
+            convertRGBSpan(
+              sc,
+              x + pending,
+              y,
+              end - pending,
+              &rgb[3 * pending]);
+
+            for (size_t i = pending; i < end; i++) {
+                SpectrumMemo::Pixel missed;
+                missed.nComponents = pixelComponents(
+                  x + i,
+                  y,
+                  missed.data.data(),
+                  missed.size.data());
+
+                memo.insert(hashes[i], missed, &rgb[3 * i]);
+            }
+
+            pending = n;
+        };
+
+        for (size_t i = 0; i < n; i++) {
+            float *out = &rgb[3 * i];
+
+            current.nComponents = pixelComponents(
+              x + i,
+              y,
+              current.data.data(),
+              current.size.data());
+
+            // Runs of identical pixels are common in the images this
+            // pays off for: check the previous pixel before hashing
+            if (i > 0 && SpectrumMemo::equal(previous, current)) {
+                flush(i);
+                memcpy(out, out - 3, 3 * sizeof(float));
+                hits++;
+            } else {
+                hashes[i] = SpectrumMemo::hash(current);
+
+                if (memo.find(hashes[i], current, out)) {
+                    flush(i);
+                    hits++;
+                } else if (pending == n) {
+                    pending = i;
+                }
             }
+
+            previous = current;
+        }
+
+        flush(n);
+
+        // Updated once per span to limit the contention
+        memo.hits += hits;
+        memo.misses += n - hits;
+    }
+
+
+    size_t SpectralImage::pixelComponents(
+      size_t        x,
+      size_t        y,
+      const float **data,
+      size_t *      sizes) const
+    {
+        const size_t i           = nSpectralBands() * (y * width() + x);
+        size_t       nComponents = 0;
+
+        if (isReflective()) {
+            data[nComponents]  = &_reflectivePixelBuffer[i];
+            sizes[nComponents] = nSpectralBands();
+            nComponents++;
         }
 
-        // Exposure compensation
-        for (size_t i = 0; i < width() * height(); i++) {
-            for (size_t c = 0; c < 3; c++) {
-                rgbImage[3 * i + c] *= std::pow(2.F, _ev);
+        if (isEmissive()) {
+            data[nComponents]  = &_emissivePixelBuffers[0][i];
+            sizes[nComponents] = nSpectralBands();
+            nComponents++;
+        }
+
+        return nComponents;
+    }
+
+
+    SpectrumType SpectralImage::rgbConversionType() const
+    {
+        // The reradiation is not handled here, no need to build
+        // the bi-spectral weights
+        SpectrumType convertedType = UNDEFINED;
+
+        if (isEmissive()) {
+            convertedType = convertedType | EMISSIVE;
+        }
+
+        if (isReflective()) {
+            convertedType = convertedType | REFLECTIVE;
+        }
+
+        return convertedType;
+    }
+
+
+    void SpectralImage::invalidatePreview() const
+    {
+        const size_t nTiles = previewTilesX() * previewTilesY();
+
+        if (_preview.dirty.size() != nTiles) {
+            _preview.dirty = std::vector<std::atomic<uint8_t>>(nTiles);
+        }
+
+        for (size_t t = 0; t < nTiles; t++) {
+            _preview.dirty[t].store(1, std::memory_order_relaxed);
+        }
+
+        _preview.rgb.resize(3 * width() * height());
+
+        // Memoised values depend on the observer and illuminant
+        if (_preview.memo) {
+            _preview.memo->clear();
+        }
+    }
+
+
+    void SpectralImage::setRGBMemoisation(bool enable, size_t memoryBudget)
+    {
+        std::lock_guard<std::mutex> lock(_preview.mutex);
+
+        _preview.memoBudget = enable ? std::max(memoryBudget, size_t(1)) : 0;
+        _preview.memo.reset();
+    }
+
+
+    bool SpectralImage::rgbMemoisation() const
+    {
+        return _preview.memoBudget > 0;
+    }
+
+
+    SpectralImage::MemoisationStats SpectralImage::rgbMemoisationStats() const
+    {
+        std::lock_guard<std::mutex> lock(_preview.mutex);
+
+        MemoisationStats stats = {0, 0};
+
+        if (_preview.memo) {
+            stats.hits   = _preview.memo->hits;
+            stats.misses = _preview.memo->misses;
+        }
+
+        return stats;
+    }
+
+
+    SpectralImage::PreviewCache::PreviewCache(): memoBudget(0) {}
+
+
+    // A copy gets its own memo, created on its first conversion
+    SpectralImage::PreviewCache::PreviewCache(const PreviewCache &other)
+      : rgb(other.rgb)
+      , dirty(other.dirty.size())
+      , memoBudget(other.memoBudget)
+    {
+        for (size_t t = 0; t < dirty.size(); t++) {
+            dirty[t].store(other.dirty[t].load(std::memory_order_relaxed));
+        }
+    }
+
+
+    SpectralImage::PreviewCache &
+    SpectralImage::PreviewCache::operator=(const PreviewCache &other)
+    {
+        if (this != &other) {
+            rgb   = other.rgb;
+            dirty = std::vector<std::atomic<uint8_t>>(other.dirty.size());
+
+            for (size_t t = 0; t < dirty.size(); t++) {
+                dirty[t].store(other.dirty[t].load(std::memory_order_relaxed));
+            }
+
+            memoBudget = other.memoBudget;
+            memo.reset();
+        }
+
+        return *this;
+    }
+
+
+    SpectralImage::PreviewCache::~PreviewCache() {}
+
+
+    void SpectralImage::getColorImages(
+      const std::vector<ColorOutput> & outputs,
+      std::vector<std::vector<float>> &images) const
+    {
+        images.resize(outputs.size());
+
+        for (size_t o = 0; o < outputs.size(); o++) {
+            images[o].resize(outputs[o].nChannels() * width() * height());
+        }
+
+        if (width() == 0 || height() == 0) {
+            return;
+        }
+
+        std::shared_ptr<const SpectrumConverter> sc
+          = SpectrumConverterCache::get(
+            _wavelengths_nm,
+            rgbConversionType(),
+            _observer,
+            _illuminant);
+
+        const float exposure = std::pow(2.F, _ev);
+        const int   nRows    = static_cast<int>(height());
+        const int   nThreads = static_cast<int>(Threading::threadCount());
+
+        // Each row is integrated once in a XYZ buffer small enough to
+        // stay in cache while it is converted to the outputs
+#pragma omp parallel num_threads(nThreads)
+        {
+            std::vector<float> xyz(3 * width());
+
+#pragma omp for schedule(dynamic)
+            for (int y = 0; y < nRows; y++) {
+                convertXYZSpan(
+                  *sc,
+                  0,
+                  size_t(y),
+                  width(),
+                  xyz.data(),
+                  exposure);
+
+                writeColorOutputs(outputs, xyz.data(), size_t(y), images);
+            }
+        }
+    }
+
+
+    void SpectralImage::writeColorOutputs(
+      const std::vector<ColorOutput> & outputs,
+      const float *                    xyz,
+      size_t                           y,
+      std::vector<std::vector<float>> &images) const
+    {
+        for (size_t o = 0; o < outputs.size(); o++) {
+            const ColorOutput &output = outputs[o];
+            float *out = &images[o][output.nChannels() * y * width()];
+
+            switch (output.type()) {
+                case ColorOutput::XYZ:
+                    memcpy(out, xyz, 3 * width() * sizeof(float));
+                    break;
+
+                case ColorOutput::RGB: {
+                    const std::array<float, 9> &m = output.matrix();
+
+                    for (size_t x = 0; x < width(); x++) {
+                        const float *XYZ = &xyz[3 * x];
+
+                        for (size_t c = 0; c < 3; c++) {
+                            const float v = m[3 * c + 0] * XYZ[0]
+                                            + m[3 * c + 1] * XYZ[1]
+                                            + m[3 * c + 2] * XYZ[2];
+
+                            // Ensure RGB values are > 0
+                            out[3 * x + c] = std::max(v, 0.F);
+                        }
+                    }
+                } break;
+
+                case ColorOutput::LUMINANCE:
+                    for (size_t x = 0; x < width(); x++) {
+                        out[x] = xyz[3 * x + 1];
+                    }
+                    break;
+
+                case ColorOutput::CHROMATICITY:
+                    for (size_t x = 0; x < width(); x++) {
+                        const float *XYZ = &xyz[3 * x];
+                        const float  sum = XYZ[0] + XYZ[1] + XYZ[2];
+
+                        out[2 * x + 0] = sum != 0.F ? XYZ[0] / sum : 0.F;
+                        out[2 * x + 1] = sum != 0.F ? XYZ[1] / sum : 0.F;
+                    }
+                    break;
             }
         }
     }
@@ -243,6 +689,40 @@ namespace SEXR
     }
 
 
+    void SpectralImage::setObserver(size_t observer)
+    {
+        if (observer >= Colorimetry::nObservers()) {
+            throw Colorimetry::INVALID_INDEX;
+        }
+
+        // getRGBImage() reads the colorimetry under this lock
+        std::lock_guard<std::mutex> lock(_preview.mutex);
+
+        _observer = observer;
+        invalidatePreview();
+    }
+
+
+    size_t SpectralImage::observer() const { return _observer; }
+
+
+    void SpectralImage::setIlluminant(size_t illuminant)
+    {
+        if (illuminant >= Colorimetry::nIlluminants()) {
+            throw Colorimetry::INVALID_INDEX;
+        }
+
+        // getRGBImage() reads the colorimetry under this lock
+        std::lock_guard<std::mutex> lock(_preview.mutex);
+
+        _illuminant = illuminant;
+        invalidatePreview();
+    }
+
+
+    size_t SpectralImage::illuminant() const { return _illuminant; }
+
+
     // Access the emissive part
 
     float &SpectralImage::emissive(
@@ -254,6 +734,8 @@ namespace SEXR
         assert(isEmissive());
         assert(stokesComponent < nStokesComponents());
 
+        invalidatePreview(x, y);
+
         return _emissivePixelBuffers[stokesComponent]
                                     [nSpectralBands() * (y * width() + x)
                                      + wavelength_idx];
@@ -283,6 +765,8 @@ namespace SEXR
         assert(wavelength_idx < nSpectralBands());
         assert(isReflective());
 
+        invalidatePreview(x, y);
+
         return _reflectivePixelBuffer
           [nSpectralBands() * (y * width() + x) + wavelength_idx];
     }
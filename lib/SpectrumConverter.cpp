@@ -35,25 +35,23 @@
  */
 
 #include "SpectrumConverter.h"
+#include "ColorimetryTables.h"
 #include "Util.h"
 #include "spectrum_data.h"
 
 #include <cstring>
 #include <cassert>
 #include <cmath>
-#include <functional>
 
 namespace SEXR
 {
     SpectrumConverter::SpectrumConverter(bool emissiveSpectrum)
       : _emissiveSpectrum(emissiveSpectrum)
+      , _illuminantFirstWavelenght_nm(D_65_FIRST_WAVELENGTH_NM)
+      , _illuminantSPD(std::begin(D_65_SPD), std::end(D_65_SPD))
       , _cmfFirstWavelength_nm(CIE1931_2DEG_FIRST_WAVELENGTH_NM)
+      , _batchKernel(SpectrumConverterKernels::kernel())
     {
-        if (!_emissiveSpectrum) {
-            _illuminantFirstWavelenght_nm = D_65_FIRST_WAVELENGTH_NM;
-            _illuminantSPD
-              = std::vector<float>(std::begin(D_65_SPD), std::end(D_65_SPD));
-        }
 
         _xyzCmfs[0] = std::vector<float>(
           std::begin(CIE1931_2DEG_X),
@@ -69,13 +67,38 @@ namespace SEXR
     }
 
 
+    SpectrumConverter::SpectrumConverter(
+      const std::vector<float> &wavelengths_nm,
+      SpectrumType              type,
+      size_t                    observer,
+      size_t                    illuminant)
+      : SpectrumConverter(isEmissiveSpectrum(type))
+    {
+        const std::shared_ptr<const ObserverTable> cmfs
+          = ColorimetryTables::observer(observer);
+        const std::shared_ptr<const IlluminantTable> spd
+          = ColorimetryTables::illuminant(illuminant);
+
+        _cmfFirstWavelength_nm        = cmfs->firstWavelength_nm;
+        _xyzCmfs                      = cmfs->xyz;
+        _illuminantFirstWavelenght_nm = spd->firstWavelength_nm;
+        _illuminantSPD                = spd->spd;
+
+        _wavelengths_nm = wavelengths_nm;
+        computeWeights(type);
+    }
+
+
     SpectrumConverter::SpectrumConverter(
       const float &                            cmfFirstWavelength_nm,
       const std::array<std::vector<float>, 3> &xyzCmfs,
       const std::array<float, 9>               xyzToRgb)
-      : _cmfFirstWavelength_nm(cmfFirstWavelength_nm)
+      : _emissiveSpectrum(true)
+      , _illuminantFirstWavelenght_nm(0)
+      , _cmfFirstWavelength_nm(cmfFirstWavelength_nm)
       , _xyzCmfs(xyzCmfs)
       , _xyzToRgb(xyzToRgb)
+      , _batchKernel(SpectrumConverterKernels::kernel())
     {}
 
 
@@ -101,6 +124,148 @@ namespace SEXR
     }
 
 
+    size_t SpectrumConverter::memoryFootprint() const
+    {
+        size_t nFloats
+          = _illuminantSPD.capacity() + _wavelengths_nm.capacity();
+
+        for (const std::vector<float> &cmf : _xyzCmfs) {
+            nFloats += cmf.capacity();
+        }
+
+        const std::vector<float> *weights[] = {
+          &_emissiveWeights,
+          &_reflectiveWeights,
+          &_diagonalWeights,
+          &_reradiationWeights,
+          &_rgbBatchWeights.emissive,
+          &_rgbBatchWeights.reflective,
+          &_rgbBatchWeights.diagonal,
+          &_rgbBatchWeights.reradiation,
+          &_xyzBatchWeights.emissive,
+          &_xyzBatchWeights.reflective,
+          &_xyzBatchWeights.diagonal,
+          &_xyzBatchWeights.reradiation};
+
+        for (const std::vector<float> *w : weights) {
+            nFloats += w->capacity();
+        }
+
+        return sizeof(SpectrumConverter) + nFloats * sizeof(float);
+    }
+
+
+    void SpectrumConverter::spectrumToXYZ(
+      const float *spectrum, std::array<float, 3> &XYZ) const
+    {
+        if (_emissiveSpectrum) {
+            weightedSum(_emissiveWeights, spectrum, XYZ);
+        } else {
+            weightedSum(_reflectiveWeights, spectrum, XYZ);
+        }
+    }
+
+
+    void SpectrumConverter::spectrumToRGB(
+      const float *spectrum, std::array<float, 3> &RGB) const
+    {
+        std::array<float, 3> XYZ;
+        spectrumToXYZ(spectrum, XYZ);
+        XYZToRGB(XYZ, RGB);
+    }
+
+
+    void SpectrumConverter::spectraToXYZ(
+      const float *         reflectiveSpectrum,
+      const float *         emissiveSpectrum,
+      std::array<float, 3> &XYZ) const
+    {
+        std::array<float, 3> XYZ_refl;
+        std::array<float, 3> XYZ_emissive;
+
+        weightedSum(_reflectiveWeights, reflectiveSpectrum, XYZ_refl);
+        weightedSum(_emissiveWeights, emissiveSpectrum, XYZ_emissive);
+
+        for (size_t c = 0; c < 3; c++) {
+            XYZ[c] = XYZ_refl[c] + XYZ_emissive[c];
+        }
+    }
+
+
+    void SpectrumConverter::spectraToRGB(
+      const float *         reflectiveSpectrum,
+      const float *         emissiveSpectrum,
+      std::array<float, 3> &RGB) const
+    {
+        std::array<float, 3> XYZ;
+        spectraToXYZ(reflectiveSpectrum, emissiveSpectrum, XYZ);
+        XYZToRGB(XYZ, RGB);
+    }
+
+
+    void SpectrumConverter::spectrumToXYZ(
+      const float *         diagonal,
+      const float *         reradiation,
+      std::array<float, 3> &XYZ) const
+    {
+        if (_emissiveSpectrum) {
+            return spectrumToXYZ(diagonal, XYZ);
+        }
+
+        std::array<float, 3> XYZ_rerad;
+
+        weightedSum(_diagonalWeights, diagonal, XYZ);
+        weightedSum(_reradiationWeights, reradiation, XYZ_rerad);
+
+        for (size_t c = 0; c < 3; c++) {
+            XYZ[c] += XYZ_rerad[c];
+        }
+    }
+
+
+    void SpectrumConverter::spectrumToRGB(
+      const float *         diagonal,
+      const float *         reradiation,
+      std::array<float, 3> &RGB) const
+    {
+        std::array<float, 3> XYZ;
+        spectrumToXYZ(diagonal, reradiation, XYZ);
+        XYZToRGB(XYZ, RGB);
+    }
+
+
+    void SpectrumConverter::spectraToXYZ(
+      const float *         diagonal,
+      const float *         reradiation,
+      const float *         emissiveSpectrum,
+      std::array<float, 3> &XYZ) const
+    {
+        std::array<float, 3> XYZ_diag;
+        std::array<float, 3> XYZ_rerad;
+        std::array<float, 3> XYZ_emissive;
+
+        weightedSum(_diagonalWeights, diagonal, XYZ_diag);
+        weightedSum(_reradiationWeights, reradiation, XYZ_rerad);
+        weightedSum(_emissiveWeights, emissiveSpectrum, XYZ_emissive);
+
+        for (size_t c = 0; c < 3; c++) {
+            XYZ[c] = XYZ_diag[c] + XYZ_rerad[c] + XYZ_emissive[c];
+        }
+    }
+
+
+    void SpectrumConverter::spectraToRGB(
+      const float *         diagonal,
+      const float *         reradiation,
+      const float *         emissiveSpectrum,
+      std::array<float, 3> &RGB) const
+    {
+        std::array<float, 3> XYZ;
+        spectraToXYZ(diagonal, reradiation, emissiveSpectrum, XYZ);
+        XYZToRGB(XYZ, RGB);
+    }
+
+
     void SpectrumConverter::spectrumToXYZ(
       const std::vector<float> &wavelengths_nm,
       const float *             spectrum,
@@ -122,17 +287,7 @@ namespace SEXR
         std::array<float, 3> XYZ;
         spectrumToXYZ(wavelengths_nm, spectrum, XYZ);
 
-        memset(&RGB[0], 0, 3 * sizeof(float));
-
-        // Convert to RGB using the provided matrix
-        for (size_t channel = 0; channel < 3; channel++) {
-            for (size_t col = 0; col < 3; col++) {
-                RGB[channel] += XYZ[col] * _xyzToRgb[3 * channel + col];
-            }
-
-            // Ensure RGB values are > 0
-            RGB[channel] = std::max(RGB[channel], 0.F);
-        }
+        XYZToRGB(XYZ, RGB);
     }
 
 
@@ -163,34 +318,140 @@ namespace SEXR
         std::array<float, 3> XYZ;
         spectraToXYZ(wavelengths_nm, reflectiveSpectrum, emissiveSpectrum, XYZ);
 
-        memset(&RGB[0], 0, 3 * sizeof(float));
+        XYZToRGB(XYZ, RGB);
+    }
 
-        // Convert to RGB using the provided matrix
-        for (size_t channel = 0; channel < 3; channel++) {
-            for (size_t col = 0; col < 3; col++) {
-                RGB[channel] += XYZ[col] * _xyzToRgb[3 * channel + col];
+
+    namespace
+    {
+        // Evaluates the bilinear interpolation of a pixel's
+        // reradiation matrix at each sample
+        class BispectralPixelVisitor
+        {
+          public:
+            BispectralPixelVisitor(
+              const float *                            diagonal,
+              const float *                            reradiation,
+              const std::array<std::vector<float>, 3> &xyzCmfs)
+              : XYZ({0.F, 0.F, 0.F})
+              , _diagonal(diagonal)
+              , _reradiation(reradiation)
+              , _xyzCmfs(xyzCmfs)
+            {}
+
+            // There is no reradiation toward shorter wavelengths
+            float value(size_t wi, size_t wo) const
+            {
+                if (wi == wo) {
+                    return _diagonal[wi];
+                } else if (wi > wo) {
+                    return 0.F;
+                }
+
+                return _reradiation[Util::idxFromWavelengthIdx(wi, wo)];
             }
 
-            // Ensure RGB values are > 0
-            RGB[channel] = std::max(RGB[channel], 0.F);
-        }
-    }
+            void operator()(
+              size_t wl_idx_i,
+              size_t wl_idx_o,
+              float  interp_illu,
+              float  interp_rerad,
+              float  illu_value,
+              size_t idx_cmf)
+            {
+                // interpolation
+                const float bispect
+                  = (1 - interp_rerad)
+                      * ((1 - interp_illu) * value(wl_idx_i, wl_idx_o)
+                         + (interp_illu)*value(wl_idx_i + 1, wl_idx_o))
+                    + (interp_rerad)
+                        * ((1 - interp_illu) * value(wl_idx_i, wl_idx_o + 1)
+                           + (interp_illu)*value(wl_idx_i + 1, wl_idx_o + 1));
+
+                const float curr_value = illu_value * bispect;
 
+                for (size_t c = 0; c < 3; c++) {
+                    XYZ[c] += curr_value * _xyzCmfs[c][idx_cmf];
+                }
+            }
 
-    void SpectrumConverter::spectrumToXYZ(
-      const std::vector<float> &wavelengths_nm,
-      const float *             diagonal,
-      const float *             reradiation,
-      std::array<float, 3> &    XYZ) const
-    {
-        memset(&XYZ[0], 0, 3 * sizeof(float));
+            std::array<float, 3> XYZ;
+
+          private:
+            const float *                            _diagonal;
+            const float *                            _reradiation;
+            const std::array<std::vector<float>, 3> &_xyzCmfs;
+        };
+
+
+        // Accumulates, for each sample, the contribution of the four
+        // surrounding elements of the reradiation matrix
+        class BispectralWeightsVisitor
+        {
+          public:
+            BispectralWeightsVisitor(
+              std::vector<float> &                     diagonalWeights,
+              std::vector<float> &                     reradiationWeights,
+              const std::array<std::vector<float>, 3> &xyzCmfs)
+              : _diagonalWeights(diagonalWeights)
+              , _reradiationWeights(reradiationWeights)
+              , _xyzCmfs(xyzCmfs)
+            {}
+
+            void operator()(
+              size_t wl_idx_i,
+              size_t wl_idx_o,
+              float  interp_illu,
+              float  interp_rerad,
+              float  illu_value,
+              size_t idx_cmf)
+            {
+                const float w_i[2] = {1 - interp_illu, interp_illu};
+                const float w_o[2] = {1 - interp_rerad, interp_rerad};
+
+                for (size_t o = 0; o < 2; o++) {
+                    for (size_t i = 0; i < 2; i++) {
+                        add(
+                          wl_idx_i + i,
+                          wl_idx_o + o,
+                          illu_value * w_o[o] * w_i[i],
+                          idx_cmf);
+                    }
+                }
+            }
 
-        if (_emissiveSpectrum) {
-            return spectrumToXYZ(wavelengths_nm, diagonal, XYZ);
-        }
+          private:
+            void add(size_t wi, size_t wo, float factor, size_t idx_cmf)
+            {
+                float *weights;
+
+                if (wi == wo) {
+                    weights = &_diagonalWeights[3 * wi];
+                } else if (wi < wo) {
+                    weights = &_reradiationWeights
+                      [3 * Util::idxFromWavelengthIdx(wi, wo)];
+                } else {
+                    return;
+                }
+
+                for (size_t c = 0; c < 3; c++) {
+                    weights[c] += factor * _xyzCmfs[c][idx_cmf];
+                }
+            }
+
+            std::vector<float> &                     _diagonalWeights;
+            std::vector<float> &                     _reradiationWeights;
+            const std::array<std::vector<float>, 3> &_xyzCmfs;
+        };
+    }   // namespace
 
+
+    template<typename Visitor>
+    float SpectrumConverter::integrateBispectral(
+      const std::vector<float> &wavelengths_nm, Visitor &visitor) const
+    {
         if (wavelengths_nm.size() == 0) {
-            return;
+            return 0;
         }
 
         const float illuminant_last_wavelength
@@ -204,22 +465,13 @@ namespace SEXR
 
         // Early exit, selection out of range
         if (end_wavelength < start_wavelength) {
-            return;
+            return 0;
         }
 
         assert(start_wavelength <= end_wavelength);
 
         float normalisation_factor(0);
 
-        std::function<float(size_t, size_t)> value
-          = [diagonal, reradiation](size_t wi, size_t wo) {
-                if (wi == wo) {
-                    return diagonal[wi];
-                }
-
-                return reradiation[Util::idxFromWavelengthIdx(wi, wo)];
-            };
-
         for (size_t wl_idx_i = 0; wl_idx_i < wavelengths_nm.size() - 1;
              wl_idx_i++) {
             float wl_i_a = wavelengths_nm[wl_idx_i];
@@ -315,25 +567,43 @@ namespace SEXR
                               += illu_value * _xyzCmfs[1][idx_cmf];   // Y
                         }
 
-                        // interpolation
-                        const float bispect
-                          = (1 - interp_rerad)
-                              * ((1 - interp_illu) * value(wl_idx_i, wl_idx_o) + (interp_illu)*value(wl_idx_i + 1, wl_idx_o))
-                            + (interp_rerad)
-                                * ((1 - interp_illu) * value(wl_idx_i, wl_idx_o + 1) + (interp_illu)*value(wl_idx_i + 1, wl_idx_o + 1));
-
-                        const float curr_value = illu_value * bispect;
-
-                        for (size_t c = 0; c < 3; c++) {
-                            XYZ[c] += curr_value * _xyzCmfs[c][idx_cmf];
-                        }
+                        visitor(
+                          wl_idx_i,
+                          wl_idx_o,
+                          interp_illu,
+                          interp_rerad,
+                          illu_value,
+                          idx_cmf);
                     }
                 }
             }
         }
 
-        for (size_t c = 0; c < 3; c++) {
-            XYZ[c] /= normalisation_factor;
+        return normalisation_factor;
+    }
+
+
+    void SpectrumConverter::spectrumToXYZ(
+      const std::vector<float> &wavelengths_nm,
+      const float *             diagonal,
+      const float *             reradiation,
+      std::array<float, 3> &    XYZ) const
+    {
+        memset(&XYZ[0], 0, 3 * sizeof(float));
+
+        if (_emissiveSpectrum) {
+            return spectrumToXYZ(wavelengths_nm, diagonal, XYZ);
+        }
+
+        BispectralPixelVisitor pixel(diagonal, reradiation, _xyzCmfs);
+
+        const float normalisation_factor
+          = integrateBispectral(wavelengths_nm, pixel);
+
+        if (normalisation_factor > 0) {
+            for (size_t c = 0; c < 3; c++) {
+                XYZ[c] = pixel.XYZ[c] / normalisation_factor;
+            }
         }
     }
 
@@ -347,17 +617,7 @@ namespace SEXR
         std::array<float, 3> XYZ;
         spectrumToXYZ(wavelengths_nm, diagonal, reradiation, XYZ);
 
-        memset(&RGB[0], 0, 3 * sizeof(float));
-
-        // Convert to RGB using the provided matrix
-        for (size_t channel = 0; channel < 3; channel++) {
-            for (size_t col = 0; col < 3; col++) {
-                RGB[channel] += XYZ[col] * _xyzToRgb[3 * channel + col];
-            }
-
-            // Ensure RGB values are > 0
-            RGB[channel] = std::max(RGB[channel], 0.F);
-        }
+        XYZToRGB(XYZ, RGB);
     }
 
     void SpectrumConverter::spectraToXYZ(
@@ -394,17 +654,7 @@ namespace SEXR
           emissiveSpectrum,
           XYZ);
 
-        memset(&RGB[0], 0, 3 * sizeof(float));
-
-        // Convert to RGB using the provided matrix
-        for (size_t channel = 0; channel < 3; channel++) {
-            for (size_t col = 0; col < 3; col++) {
-                RGB[channel] += XYZ[col] * _xyzToRgb[3 * channel + col];
-            }
-
-            // Ensure RGB values are > 0
-            RGB[channel] = std::max(RGB[channel], 0.F);
-        }
+        XYZToRGB(XYZ, RGB);
     }
 
 
@@ -575,4 +825,363 @@ namespace SEXR
         }
     }
 
+
+    void SpectrumConverter::computeWeights(SpectrumType type)
+    {
+        const size_t nBands = _wavelengths_nm.size();
+
+        // Both spectral integrations are linear in the spectrum:
+        // integrating each basis spectrum gives the contribution of
+        // each band
+        std::vector<float>   basis(nBands, 0.F);
+        std::array<float, 3> XYZ;
+
+        if (isEmissiveSpectrum(type)) {
+            _emissiveWeights.resize(3 * nBands);
+
+            for (size_t wl_idx = 0; wl_idx < nBands; wl_idx++) {
+                basis[wl_idx] = 1.F;
+                emissiveSpectrumToXYZ(_wavelengths_nm, basis.data(), XYZ);
+                basis[wl_idx] = 0.F;
+
+                memcpy(
+                  &_emissiveWeights[3 * wl_idx],
+                  &XYZ[0],
+                  3 * sizeof(float));
+            }
+        }
+
+        if (isReflectiveSpectrum(type)) {
+            _reflectiveWeights.resize(3 * nBands);
+
+            for (size_t wl_idx = 0; wl_idx < nBands; wl_idx++) {
+                basis[wl_idx] = 1.F;
+                reflectiveSpectrumToXYZ(_wavelengths_nm, basis.data(), XYZ);
+                basis[wl_idx] = 0.F;
+
+                memcpy(
+                  &_reflectiveWeights[3 * wl_idx],
+                  &XYZ[0],
+                  3 * sizeof(float));
+            }
+        }
+
+        // The bi-spectral integration is also linear but has
+        // N * (N + 1) / 2 unknowns, the weights are accumulated in a
+        // single pass instead
+        if (isBispectralSpectrum(type) && nBands > 0) {
+            _diagonalWeights.assign(3 * nBands, 0.F);
+            _reradiationWeights.assign(3 * nBands * (nBands - 1) / 2, 0.F);
+
+            BispectralWeightsVisitor weights(
+              _diagonalWeights,
+              _reradiationWeights,
+              _xyzCmfs);
+
+            const float normalisation_factor
+              = integrateBispectral(_wavelengths_nm, weights);
+
+            if (normalisation_factor > 0) {
+                for (float &w : _diagonalWeights) {
+                    w /= normalisation_factor;
+                }
+
+                for (float &w : _reradiationWeights) {
+                    w /= normalisation_factor;
+                }
+            }
+        }
+
+        _batchKernel = SpectrumConverterKernels::kernel(nBands);
+
+        const std::array<float, 9> identity
+          = {1.F, 0.F, 0.F, 0.F, 1.F, 0.F, 0.F, 0.F, 1.F};
+
+        computeBatchWeights(_xyzToRgb, _rgbBatchWeights);
+        computeBatchWeights(identity, _xyzBatchWeights);
+    }
+
+
+    void SpectrumConverter::computeBatchWeights(
+      const std::array<float, 9> &matrix, BatchWeights &batchWeights) const
+    {
+        const std::vector<float> *xyzWeights[4]
+          = {&_emissiveWeights,
+             &_reflectiveWeights,
+             &_diagonalWeights,
+             &_reradiationWeights};
+
+        std::vector<float> *columns[4]
+          = {&batchWeights.emissive,
+             &batchWeights.reflective,
+             &batchWeights.diagonal,
+             &batchWeights.reradiation};
+
+        for (size_t w = 0; w < 4; w++) {
+            const size_t size = xyzWeights[w]->size() / 3;
+            const size_t pad  = SpectrumConverterKernels::paddedSize(size);
+
+            // Padding is left to 0 so it does not contribute
+            columns[w]->assign(3 * pad, 0.F);
+
+            for (size_t idx = 0; idx < size; idx++) {
+                for (size_t channel = 0; channel < 3; channel++) {
+                    float v = 0.F;
+
+                    for (size_t col = 0; col < 3; col++) {
+                        v += (*xyzWeights[w])[3 * idx + col]
+                             * matrix[3 * channel + col];
+                    }
+
+                    (*columns[w])[channel * pad + idx] = v;
+                }
+            }
+        }
+    }
+
+
+    void SpectrumConverter::spectrumBatch(
+      const BatchWeights &weights,
+      bool                clamp,
+      const float *       spectra,
+      size_t              nSpectra,
+      float *             out,
+      float               scale) const
+    {
+        const BatchTerm term
+          = {spectra,
+             _wavelengths_nm.size(),
+             _emissiveSpectrum ? weights.emissive.data()
+                               : weights.reflective.data()};
+
+        _batchKernel(&term, 1, nSpectra, scale, clamp, out);
+    }
+
+
+    void SpectrumConverter::spectraBatch(
+      const BatchWeights &weights,
+      bool                clamp,
+      const float *       reflectiveSpectra,
+      const float *       emissiveSpectra,
+      size_t              nSpectra,
+      float *             out,
+      float               scale) const
+    {
+        const size_t    nBands   = _wavelengths_nm.size();
+        const BatchTerm terms[2] = {
+          {reflectiveSpectra, nBands, weights.reflective.data()},
+          {emissiveSpectra, nBands, weights.emissive.data()}};
+
+        _batchKernel(terms, 2, nSpectra, scale, clamp, out);
+    }
+
+
+    void SpectrumConverter::bispectralBatch(
+      const BatchWeights &weights,
+      bool                clamp,
+      const float *       diagonals,
+      const float *       reradiations,
+      const float *       emissiveSpectra,
+      size_t              nSpectra,
+      float *             out,
+      float               scale) const
+    {
+        const size_t    nBands   = _wavelengths_nm.size();
+        const BatchTerm terms[3] = {
+          {diagonals, nBands, weights.diagonal.data()},
+          {reradiations,
+           _reradiationWeights.size() / 3,
+           weights.reradiation.data()},
+          {emissiveSpectra, nBands, weights.emissive.data()}};
+
+        // The emissive term is last, so it is skipped when absent
+        _batchKernel(
+          terms,
+          emissiveSpectra != nullptr ? 3 : 2,
+          nSpectra,
+          scale,
+          clamp,
+          out);
+    }
+
+
+    void SpectrumConverter::spectrumToXYZBatch(
+      const float *spectra,
+      size_t       nSpectra,
+      float *      xyz,
+      float        scale) const
+    {
+        spectrumBatch(_xyzBatchWeights, false, spectra, nSpectra, xyz, scale);
+    }
+
+
+    void SpectrumConverter::spectrumToRGBBatch(
+      const float *spectra,
+      size_t       nSpectra,
+      float *      rgb,
+      float        scale) const
+    {
+        spectrumBatch(_rgbBatchWeights, true, spectra, nSpectra, rgb, scale);
+    }
+
+
+    void SpectrumConverter::spectraToXYZBatch(
+      const float *reflectiveSpectra,
+      const float *emissiveSpectra,
+      size_t       nSpectra,
+      float *      xyz,
+      float        scale) const
+    {
+        spectraBatch(
+          _xyzBatchWeights,
+          false,
+          reflectiveSpectra,
+          emissiveSpectra,
+          nSpectra,
+          xyz,
+          scale);
+    }
+
+
+    void SpectrumConverter::spectraToRGBBatch(
+      const float *reflectiveSpectra,
+      const float *emissiveSpectra,
+      size_t       nSpectra,
+      float *      rgb,
+      float        scale) const
+    {
+        spectraBatch(
+          _rgbBatchWeights,
+          true,
+          reflectiveSpectra,
+          emissiveSpectra,
+          nSpectra,
+          rgb,
+          scale);
+    }
+
+
+    void SpectrumConverter::spectrumToXYZBatch(
+      const float *diagonals,
+      const float *reradiations,
+      size_t       nSpectra,
+      float *      xyz,
+      float        scale) const
+    {
+        if (_emissiveSpectrum) {
+            spectrumToXYZBatch(diagonals, nSpectra, xyz, scale);
+            return;
+        }
+
+        bispectralBatch(
+          _xyzBatchWeights,
+          false,
+          diagonals,
+          reradiations,
+          nullptr,
+          nSpectra,
+          xyz,
+          scale);
+    }
+
+
+    void SpectrumConverter::spectrumToRGBBatch(
+      const float *diagonals,
+      const float *reradiations,
+      size_t       nSpectra,
+      float *      rgb,
+      float        scale) const
+    {
+        if (_emissiveSpectrum) {
+            spectrumToRGBBatch(diagonals, nSpectra, rgb, scale);
+            return;
+        }
+
+        bispectralBatch(
+          _rgbBatchWeights,
+          true,
+          diagonals,
+          reradiations,
+          nullptr,
+          nSpectra,
+          rgb,
+          scale);
+    }
+
+
+    void SpectrumConverter::spectraToXYZBatch(
+      const float *diagonals,
+      const float *reradiations,
+      const float *emissiveSpectra,
+      size_t       nSpectra,
+      float *      xyz,
+      float        scale) const
+    {
+        bispectralBatch(
+          _xyzBatchWeights,
+          false,
+          diagonals,
+          reradiations,
+          emissiveSpectra,
+          nSpectra,
+          xyz,
+          scale);
+    }
+
+
+    void SpectrumConverter::spectraToRGBBatch(
+      const float *diagonals,
+      const float *reradiations,
+      const float *emissiveSpectra,
+      size_t       nSpectra,
+      float *      rgb,
+      float        scale) const
+    {
+        bispectralBatch(
+          _rgbBatchWeights,
+          true,
+          diagonals,
+          reradiations,
+          emissiveSpectra,
+          nSpectra,
+          rgb,
+          scale);
+    }
+
+
+    void SpectrumConverter::weightedSum(
+      const std::vector<float> &weights,
+      const float *             spectrum,
+      std::array<float, 3> &    XYZ) const
+    {
+        float X = 0.F, Y = 0.F, Z = 0.F;
+
+        for (size_t idx = 0; idx < weights.size() / 3; idx++) {
+            X += spectrum[idx] * weights[3 * idx + 0];
+            Y += spectrum[idx] * weights[3 * idx + 1];
+            Z += spectrum[idx] * weights[3 * idx + 2];
+        }
+
+        XYZ[0] = X;
+        XYZ[1] = Y;
+        XYZ[2] = Z;
+    }
+
+
+    void SpectrumConverter::XYZToRGB(
+      const std::array<float, 3> &XYZ, std::array<float, 3> &RGB) const
+    {
+        memset(&RGB[0], 0, 3 * sizeof(float));
+
+        // Convert to RGB using the provided matrix
+        for (size_t channel = 0; channel < 3; channel++) {
+            for (size_t col = 0; col < 3; col++) {
+                RGB[channel] += XYZ[col] * _xyzToRgb[3 * channel + col];
+            }
+
+            // Ensure RGB values are > 0
+            RGB[channel] = std::max(RGB[channel], 0.F);
+        }
+    }
+
 }   // namespace SEXR
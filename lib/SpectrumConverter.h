@@ -40,6 +40,11 @@
 #include <vector>
 #include <cstddef>
 
+#include <Colorimetry.h>
+#include <SpectrumType.h>
+
+#include "SpectrumConverterKernels.h"
+
 namespace SEXR
 {
     class SpectrumConverter
@@ -47,6 +52,29 @@ namespace SEXR
       public:
         SpectrumConverter(bool emissiveSpectrum = true);
 
+        /**
+         * Creates a converter bound to a specific wavelength grid.
+         * The CMFs, the illuminant and the normalisation are folded
+         * once in a N x 3 weight matrix so converting a spectrum
+         * sampled on this grid only costs N x 3 multiply-adds.
+         * For bispectral types, a weight tensor is also built for
+         * the reradiation triangle.
+         *
+         * @param wavelengths_nm wavelengths in nanometers of the
+         * spectra to convert.
+         * @param type spectrum type to convert. If the type is
+         * emissive, spectrumToXYZ() expects emissive spectra.
+         * @param observer index of the colour matching functions in
+         * the Colorimetry catalogue.
+         * @param illuminant index of the illuminant lighting
+         * reflective spectra in the Colorimetry catalogue.
+         */
+        SpectrumConverter(
+          const std::vector<float> &wavelengths_nm,
+          SpectrumType              type,
+          size_t observer   = Colorimetry::OBSERVER_CIE1931_2DEG,
+          size_t illuminant = Colorimetry::ILLUMINANT_D65);
+
         SpectrumConverter(
           const float &                            cmfFirstWavelength_nm,
           const std::array<std::vector<float>, 3> &xyzCmfs,
@@ -61,6 +89,117 @@ namespace SEXR
         size_t cmfWavelengthIndex(float wavelength_nm) const;
         size_t cmfWavelengthValue(size_t index) const;
 
+        /** Wavelength grid the precomputed weights are built for. */
+        const std::vector<float> &wavelengths_nm() const
+        {
+            return _wavelengths_nm;
+        }
+
+        /** Number of bytes used by the converter tables. */
+        size_t memoryFootprint() const;
+
+        // Precomputed path: the spectra must be sampled on the
+        // wavelength grid provided at construction.
+        void
+        spectrumToXYZ(const float *spectrum, std::array<float, 3> &XYZ) const;
+
+        void
+        spectrumToRGB(const float *spectrum, std::array<float, 3> &RGB) const;
+
+        void spectraToXYZ(
+          const float *         reflectiveSpectrum,
+          const float *         emissiveSpectrum,
+          std::array<float, 3> &XYZ) const;
+
+        void spectraToRGB(
+          const float *         reflectiveSpectrum,
+          const float *         emissiveSpectrum,
+          std::array<float, 3> &RGB) const;
+
+        // Precomputed bi-spectral path
+        void spectrumToXYZ(
+          const float *         diagonal,
+          const float *         reradiation,
+          std::array<float, 3> &XYZ) const;
+
+        void spectrumToRGB(
+          const float *         diagonal,
+          const float *         reradiation,
+          std::array<float, 3> &RGB) const;
+
+        void spectraToXYZ(
+          const float *         diagonal,
+          const float *         reradiation,
+          const float *         emissiveSpectrum,
+          std::array<float, 3> &XYZ) const;
+
+        void spectraToRGB(
+          const float *         diagonal,
+          const float *         reradiation,
+          const float *         emissiveSpectrum,
+          std::array<float, 3> &RGB) const;
+
+        // Batched precomputed path: converts nSpectra contiguous
+        // pixels at once, writing 3 floats per pixel. RGB results are
+        // clamped to zero, then all results are multiplied by scale.
+        // The inner loops use the widest SIMD instructions the CPU
+        // supports.
+        void spectrumToXYZBatch(
+          const float *spectra,
+          size_t       nSpectra,
+          float *      xyz,
+          float        scale = 1.F) const;
+
+        void spectraToXYZBatch(
+          const float *reflectiveSpectra,
+          const float *emissiveSpectra,
+          size_t       nSpectra,
+          float *      xyz,
+          float        scale = 1.F) const;
+
+        void spectrumToXYZBatch(
+          const float *diagonals,
+          const float *reradiations,
+          size_t       nSpectra,
+          float *      xyz,
+          float        scale = 1.F) const;
+
+        void spectraToXYZBatch(
+          const float *diagonals,
+          const float *reradiations,
+          const float *emissiveSpectra,
+          size_t       nSpectra,
+          float *      xyz,
+          float        scale = 1.F) const;
+
+        void spectrumToRGBBatch(
+          const float *spectra,
+          size_t       nSpectra,
+          float *      rgb,
+          float        scale = 1.F) const;
+
+        void spectraToRGBBatch(
+          const float *reflectiveSpectra,
+          const float *emissiveSpectra,
+          size_t       nSpectra,
+          float *      rgb,
+          float        scale = 1.F) const;
+
+        void spectrumToRGBBatch(
+          const float *diagonals,
+          const float *reradiations,
+          size_t       nSpectra,
+          float *      rgb,
+          float        scale = 1.F) const;
+
+        void spectraToRGBBatch(
+          const float *diagonals,
+          const float *reradiations,
+          const float *emissiveSpectra,
+          size_t       nSpectra,
+          float *      rgb,
+          float        scale = 1.F) const;
+
         // The spectrum provided must be either emissive or reflective.
         // This depends on the constructor used.
         void spectrumToXYZ(
@@ -129,6 +268,66 @@ namespace SEXR
           const float *             spectrum,
           std::array<float, 3> &    XYZ) const;
 
+        // Walks the illuminant and CMF samples of each pair of
+        // bands and calls the visitor for each of them. Returns the
+        // normalisation factor.
+        template<typename Visitor>
+        float integrateBispectral(
+          const std::vector<float> &wavelengths_nm, Visitor &visitor) const;
+
+        // Integrates each basis spectrum of the wavelength grid to
+        // build the weight matrices
+        void computeWeights(SpectrumType type);
+
+        // Weights of the batch kernels, multiplied by a 3x3 matrix
+        // and stored as columns[c * paddedSize + wl_idx]
+        struct BatchWeights {
+            std::vector<float> emissive;
+            std::vector<float> reflective;
+            std::vector<float> diagonal;
+            std::vector<float> reradiation;
+        };
+
+        void computeBatchWeights(
+          const std::array<float, 9> &matrix,
+          BatchWeights &              batchWeights) const;
+
+        void spectrumBatch(
+          const BatchWeights &weights,
+          bool                clamp,
+          const float *       spectra,
+          size_t              nSpectra,
+          float *             out,
+          float               scale) const;
+
+        void spectraBatch(
+          const BatchWeights &weights,
+          bool                clamp,
+          const float *       reflectiveSpectra,
+          const float *       emissiveSpectra,
+          size_t              nSpectra,
+          float *             out,
+          float               scale) const;
+
+        // emissiveSpectra may be null for non emissive images
+        void bispectralBatch(
+          const BatchWeights &weights,
+          bool                clamp,
+          const float *       diagonals,
+          const float *       reradiations,
+          const float *       emissiveSpectra,
+          size_t              nSpectra,
+          float *             out,
+          float               scale) const;
+
+        void weightedSum(
+          const std::vector<float> &weights,
+          const float *             spectrum,
+          std::array<float, 3> &    XYZ) const;
+
+        void XYZToRGB(
+          const std::array<float, 3> &XYZ, std::array<float, 3> &RGB) const;
+
 
         bool _emissiveSpectrum;
 
@@ -138,6 +337,24 @@ namespace SEXR
         float                             _cmfFirstWavelength_nm;
         std::array<std::vector<float>, 3> _xyzCmfs;
         std::array<float, 9>              _xyzToRgb;
+
+        // Weights are stored as weights[3 * wl_idx + c]
+        std::vector<float> _wavelengths_nm;
+        std::vector<float> _emissiveWeights;
+        std::vector<float> _reflectiveWeights;
+
+        // Bi-spectral weights, the reradiation ones follow the
+        // BiSpectralImage triangle layout
+        std::vector<float> _diagonalWeights;
+        std::vector<float> _reradiationWeights;
+
+        // Same weights for the batch kernels: the RGB ones have the
+        // XYZ to RGB matrix folded in
+        BatchWeights _rgbBatchWeights;
+        BatchWeights _xyzBatchWeights;
+
+        // Specialised for the number of bands of the grid if possible
+        BatchKernel _batchKernel;
     };
 
 }   // namespace SEXR
@@ -0,0 +1,327 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SpectrumConverterCache.h"
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+
+namespace SEXR
+{
+    namespace
+    {
+        // Converters are a few kilobytes each, except bi-spectral
+        // ones which grow with the square of the number of bands
+        const size_t DEFAULT_MEMORY_BUDGET = 32 * 1024 * 1024;
+
+        struct ConverterKey {
+            const WavelengthGrid *grid;
+            SpectrumType          type;
+            size_t                observer;
+            size_t                illuminant;
+
+            bool operator==(const ConverterKey &other) const
+            {
+                return grid == other.grid && type == other.type
+                       && observer == other.observer
+                       && illuminant == other.illuminant;
+            }
+        };
+
+        struct ConverterKeyHash {
+            size_t operator()(const ConverterKey &key) const
+            {
+                size_t hash = key.grid->hash();
+
+                hash = hash * 31 + size_t(key.type);
+                hash = hash * 31 + key.observer;
+                hash = hash * 31 + key.illuminant;
+
+                return hash;
+            }
+        };
+
+        struct CacheEntry {
+            ConverterKey key;
+
+            // Keeps the grid interned while the converter is cached
+            std::shared_ptr<const WavelengthGrid>    grid;
+            std::shared_ptr<const SpectrumConverter> converter;
+            size_t                                   footprint;
+        };
+
+        // Most recently used entries first
+        typedef std::list<CacheEntry> CacheEntries;
+
+        struct CacheState {
+            std::mutex mutex;
+
+            std::unordered_multimap<size_t, std::weak_ptr<const WavelengthGrid>>
+                   grids;
+            size_t gridSweepThreshold = 64;
+
+            CacheEntries entries;
+            std::unordered_map<
+              ConverterKey,
+              CacheEntries::iterator,
+              ConverterKeyHash>
+              index;
+
+            size_t budget = DEFAULT_MEMORY_BUDGET;
+            size_t usage  = 0;
+        };
+
+
+        CacheState &cacheState()
+        {
+            static CacheState state;
+            return state;
+        }
+
+
+        // FNV-1a on the float bit patterns
+        size_t hashWavelengths(const std::vector<float> &wavelengths_nm)
+        {
+            uint64_t hash = 14695981039346656037ULL;
+
+            for (float wl : wavelengths_nm) {
+                uint32_t bits;
+                memcpy(&bits, &wl, sizeof(uint32_t));
+
+                hash ^= bits;
+                hash *= 1099511628211ULL;
+            }
+
+            return size_t(hash);
+        }
+
+
+        bool sameWavelengths(
+          const std::vector<float> &a, const std::vector<float> &b)
+        {
+            return a.size() == b.size()
+                   && (a.empty()
+                       || memcmp(a.data(), b.data(), a.size() * sizeof(float))
+                            == 0);
+        }
+
+
+        // Must be called with the cache mutex held
+        void evict(CacheState &state)
+        {
+            while (state.usage > state.budget && state.entries.size() > 1) {
+                const CacheEntry &last = state.entries.back();
+
+                state.usage -= last.footprint;
+                state.index.erase(last.key);
+                state.entries.pop_back();
+            }
+        }
+    }   // namespace
+
+
+    WavelengthGrid::WavelengthGrid(
+      const std::vector<float> &wavelengths_nm, size_t hash)
+      : _wavelengths_nm(wavelengths_nm)
+      , _hash(hash)
+    {}
+
+
+    std::shared_ptr<const WavelengthGrid>
+    WavelengthGrid::intern(const std::vector<float> &wavelengths_nm)
+    {
+        const size_t hash  = hashWavelengths(wavelengths_nm);
+        CacheState & state = cacheState();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        auto range = state.grids.equal_range(hash);
+
+        for (auto it = range.first; it != range.second;) {
+            std::shared_ptr<const WavelengthGrid> grid = it->second.lock();
+
+            if (!grid) {
+                it = state.grids.erase(it);
+            } else if (sameWavelengths(
+                         grid->wavelengths_nm(),
+                         wavelengths_nm)) {
+                return grid;
+            } else {
+                ++it;
+            }
+        }
+
+        // Grids nobody holds anymore are only found when hashing to
+        // the same bucket, sweep them from time to time
+        if (state.grids.size() >= state.gridSweepThreshold) {
+            for (auto it = state.grids.begin(); it != state.grids.end();) {
+                if (it->second.expired()) {
+                    it = state.grids.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            state.gridSweepThreshold = std::max(
+              size_t(64),
+              2 * state.grids.size());
+        }
+
+        std::shared_ptr<const WavelengthGrid> grid(
+          new WavelengthGrid(wavelengths_nm, hash));
+
+        state.grids.emplace(hash, grid);
+
+        return grid;
+    }
+
+
+    std::shared_ptr<const SpectrumConverter> SpectrumConverterCache::get(
+      const std::vector<float> &wavelengths_nm,
+      SpectrumType              type,
+      size_t                    observer,
+      size_t                    illuminant)
+    {
+        return get(
+          WavelengthGrid::intern(wavelengths_nm),
+          type,
+          observer,
+          illuminant);
+    }
+
+
+    std::shared_ptr<const SpectrumConverter> SpectrumConverterCache::get(
+      const std::shared_ptr<const WavelengthGrid> &grid,
+      SpectrumType                                 type,
+      size_t                                       observer,
+      size_t                                       illuminant)
+    {
+        const ConverterKey key   = {grid.get(), type, observer, illuminant};
+        CacheState &       state = cacheState();
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            auto found = state.index.find(key);
+
+            if (found != state.index.end()) {
+                state.entries.splice(
+                  state.entries.begin(),
+                  state.entries,
+                  found->second);
+
+                return found->second->converter;
+            }
+        }
+
+        // Building the weights may take a while for bi-spectral
+        // types, do not block the other threads meanwhile
+        std::shared_ptr<const SpectrumConverter> converter
+          = std::make_shared<const SpectrumConverter>(
+            grid->wavelengths_nm(),
+            type,
+            observer,
+            illuminant);
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        // Another thread may have built the same converter
+        auto found = state.index.find(key);
+
+        if (found != state.index.end()) {
+            return found->second->converter;
+        }
+
+        const CacheEntry entry
+          = {key, grid, converter, converter->memoryFootprint()};
+
+        state.entries.push_front(entry);
+        state.index[key] = state.entries.begin();
+        state.usage += entry.footprint;
+
+        evict(state);
+
+        return converter;
+    }
+
+
+    void SpectrumConverterCache::setMemoryBudget(size_t bytes)
+    {
+        CacheState &state = cacheState();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        state.budget = bytes;
+        evict(state);
+    }
+
+
+    size_t SpectrumConverterCache::memoryBudget()
+    {
+        CacheState &state = cacheState();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        return state.budget;
+    }
+
+
+    size_t SpectrumConverterCache::memoryUsage()
+    {
+        CacheState &state = cacheState();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        return state.usage;
+    }
+
+
+    void SpectrumConverterCache::clear()
+    {
+        CacheState &state = cacheState();
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        state.index.clear();
+        state.entries.clear();
+        state.usage = 0;
+    }
+
+}   // namespace SEXR
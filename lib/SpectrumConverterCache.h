@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "SpectrumConverter.h"
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace SEXR
+{
+    /**
+     * Immutable wavelength grid. Grids are interned: two grids
+     * holding the same wavelengths are the same object, so they can
+     * be compared by pointer.
+     */
+    class WavelengthGrid
+    {
+      public:
+        /**
+         * Gets the unique grid for the provided wavelengths. The grid
+         * lives as long as someone holds it.
+         *
+         * @param wavelengths_nm wavelengths in nanometers.
+         */
+        static std::shared_ptr<const WavelengthGrid>
+        intern(const std::vector<float> &wavelengths_nm);
+
+        const std::vector<float> &wavelengths_nm() const
+        {
+            return _wavelengths_nm;
+        }
+
+        size_t hash() const { return _hash; }
+
+      private:
+        WavelengthGrid(const std::vector<float> &wavelengths_nm, size_t hash);
+
+        const std::vector<float> _wavelengths_nm;
+        const size_t             _hash;
+    };
+
+
+    /**
+     * Process wide cache of immutable converters, shared between
+     * threads and images using the same wavelength grid, spectrum
+     * type, observer and illuminant. Least recently used converters
+     * are evicted once their total footprint exceeds the memory
+     * budget; evicted converters stay valid for the callers still
+     * holding them.
+     */
+    class SpectrumConverterCache
+    {
+      public:
+        /**
+         * Gets a converter bound to the provided wavelength grid,
+         * building it if it is not cached.
+         *
+         * @param wavelengths_nm wavelengths in nanometers of the
+         * spectra to convert.
+         * @param type spectrum type to convert.
+         * @param observer index of the colour matching functions in
+         * the Colorimetry catalogue.
+         * @param illuminant index of the illuminant in the
+         * Colorimetry catalogue.
+         */
+        static std::shared_ptr<const SpectrumConverter> get(
+          const std::vector<float> &wavelengths_nm,
+          SpectrumType              type,
+          size_t observer   = Colorimetry::OBSERVER_CIE1931_2DEG,
+          size_t illuminant = Colorimetry::ILLUMINANT_D65);
+
+        static std::shared_ptr<const SpectrumConverter> get(
+          const std::shared_ptr<const WavelengthGrid> &grid,
+          SpectrumType                                 type,
+          size_t observer   = Colorimetry::OBSERVER_CIE1931_2DEG,
+          size_t illuminant = Colorimetry::ILLUMINANT_D65);
+
+        /**
+         * Sets the maximum number of bytes the cached converters may
+         * use. The most recently used converter is always kept.
+         */
+        static void setMemoryBudget(size_t bytes);
+
+        static size_t memoryBudget();
+
+        /** Gets the number of bytes used by the cached converters. */
+        static size_t memoryUsage();
+
+        /** Removes all the cached converters. */
+        static void clear();
+    };
+
+}   // namespace SEXR
@@ -0,0 +1,528 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SpectrumConverterKernels.h"
+#include "CpuFeatures.h"
+
+#include <algorithm>
+
+namespace SEXR
+{
+    // Number of reradiation values for n spectral bands
+    static constexpr size_t triangleSize(size_t n)
+    {
+        return n > 1 ? n * (n - 1) / 2 : 0;
+    }
+
+
+    // When SIZE > 0, it overrides size so the loops bounds are known
+    // at compile time
+    template<size_t SIZE>
+    static inline void scalarAccumulate(
+      const float *data, const float *weights, size_t size, float acc[3])
+    {
+        const size_t n   = SIZE > 0 ? SIZE : size;
+        const size_t pad = SpectrumConverterKernels::paddedSize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            acc[0] += data[i] * weights[i];
+            acc[1] += data[i] * weights[pad + i];
+            acc[2] += data[i] * weights[2 * pad + i];
+        }
+    }
+
+
+    // N > 0 specialises the kernel for images with N spectral bands:
+    // each term then holds either N values or the N * (N - 1) / 2
+    // values of the reradiation triangle.
+    template<size_t N>
+    static void scalarKernel(
+      const BatchTerm *terms,
+      size_t           nTerms,
+      size_t           nPixels,
+      float            scale,
+      bool             clamp,
+      float *          out)
+    {
+        for (size_t p = 0; p < nPixels; p++) {
+            float acc[3] = {0.F, 0.F, 0.F};
+
+            for (size_t t = 0; t < nTerms; t++) {
+                const BatchTerm &term = terms[t];
+                const float *    data = term.data + p * term.size;
+
+                if (N > 0 && term.size == N) {
+                    scalarAccumulate<N>(data, term.weights, N, acc);
+                } else if (N > 1 && term.size == triangleSize(N)) {
+                    scalarAccumulate<triangleSize(N)>(
+                      data,
+                      term.weights,
+                      term.size,
+                      acc);
+                } else {
+                    scalarAccumulate<0>(data, term.weights, term.size, acc);
+                }
+            }
+
+            for (size_t c = 0; c < 3; c++) {
+                const float v = clamp ? std::max(acc[c], 0.F) : acc[c];
+                out[3 * p + c] = v * scale;
+            }
+        }
+    }
+
+
+#ifdef SEXR_X86_KERNELS
+    // Horizontal sums of a, b and c in the three first lanes
+    SEXR_TARGET("sse4.1")
+    static inline __m128 hsum3(__m128 a, __m128 b, __m128 c)
+    {
+        const __m128 ab = _mm_hadd_ps(a, b);
+        const __m128 cz = _mm_hadd_ps(c, _mm_setzero_ps());
+
+        return _mm_hadd_ps(ab, cz);
+    }
+
+
+    // Clamps to 0 if requested, applies the scale and writes the 3
+    // first lanes
+    SEXR_TARGET("sse4.1")
+    static inline void store3(__m128 v, float scale, bool clamp, float *out)
+    {
+        if (clamp) {
+            v = _mm_max_ps(v, _mm_setzero_ps());
+        }
+
+        v = _mm_mul_ps(v, _mm_set1_ps(scale));
+
+        _mm_storel_pi(reinterpret_cast<__m64 *>(out), v);
+        _mm_store_ss(out + 2, _mm_movehl_ps(v, v));
+    }
+
+
+    template<size_t SIZE>
+    SEXR_TARGET("sse4.1")
+    static inline void sse41Accumulate(
+      const float *data,
+      const float *weights,
+      size_t       size,
+      __m128 &     acc0,
+      __m128 &     acc1,
+      __m128 &     acc2,
+      float        tail[3])
+    {
+        const size_t n   = SIZE > 0 ? SIZE : size;
+        const size_t pad = SpectrumConverterKernels::paddedSize(n);
+
+        const float *w0 = weights;
+        const float *w1 = w0 + pad;
+        const float *w2 = w1 + pad;
+
+        const size_t nVectors = n & ~size_t(3);
+
+        for (size_t i = 0; i < nVectors; i += 4) {
+            const __m128 v = _mm_loadu_ps(data + i);
+
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(v, _mm_loadu_ps(w0 + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(v, _mm_loadu_ps(w1 + i)));
+            acc2 = _mm_add_ps(acc2, _mm_mul_ps(v, _mm_loadu_ps(w2 + i)));
+        }
+
+        for (size_t i = nVectors; i < n; i++) {
+            tail[0] += data[i] * w0[i];
+            tail[1] += data[i] * w1[i];
+            tail[2] += data[i] * w2[i];
+        }
+    }
+
+
+    template<size_t N>
+    SEXR_TARGET("sse4.1")
+    static void sse41Kernel(
+      const BatchTerm *terms,
+      size_t           nTerms,
+      size_t           nPixels,
+      float            scale,
+      bool             clamp,
+      float *          out)
+    {
+        for (size_t p = 0; p < nPixels; p++) {
+            __m128 acc0    = _mm_setzero_ps();
+            __m128 acc1    = _mm_setzero_ps();
+            __m128 acc2    = _mm_setzero_ps();
+            float  tail[3] = {0.F, 0.F, 0.F};
+
+            for (size_t t = 0; t < nTerms; t++) {
+                const BatchTerm &term = terms[t];
+                const float *    data = term.data + p * term.size;
+
+                if (N > 0 && term.size == N) {
+                    sse41Accumulate<N>(
+                      data,
+                      term.weights,
+                      N,
+                      acc0,
+                      acc1,
+                      acc2,
+                      tail);
+                } else if (N > 1 && term.size == triangleSize(N)) {
+                    sse41Accumulate<triangleSize(N)>(
+                      data,
+                      term.weights,
+                      term.size,
+                      acc0,
+                      acc1,
+                      acc2,
+                      tail);
+                } else {
+                    sse41Accumulate<0>(
+                      data,
+                      term.weights,
+                      term.size,
+                      acc0,
+                      acc1,
+                      acc2,
+                      tail);
+                }
+            }
+
+            const __m128 sum = _mm_add_ps(
+              hsum3(acc0, acc1, acc2),
+              _mm_setr_ps(tail[0], tail[1], tail[2], 0.F));
+
+            store3(sum, scale, clamp, out + 3 * p);
+        }
+    }
+
+
+    // Loading 8 elements from AVX2_MASKS + 8 - n enables n lanes
+    static const int AVX2_MASKS[16]
+      = {-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+
+    template<size_t SIZE>
+    SEXR_TARGET("avx2,fma")
+    static inline void avx2Accumulate(
+      const float *data,
+      const float *weights,
+      size_t       size,
+      __m256 &     acc0,
+      __m256 &     acc1,
+      __m256 &     acc2)
+    {
+        const size_t n   = SIZE > 0 ? SIZE : size;
+        const size_t pad = SpectrumConverterKernels::paddedSize(n);
+
+        const float *w0 = weights;
+        const float *w1 = w0 + pad;
+        const float *w2 = w1 + pad;
+
+        size_t i = 0;
+
+        for (; i + 8 <= n; i += 8) {
+            const __m256 v = _mm256_loadu_ps(data + i);
+
+            acc0 = _mm256_fmadd_ps(v, _mm256_loadu_ps(w0 + i), acc0);
+            acc1 = _mm256_fmadd_ps(v, _mm256_loadu_ps(w1 + i), acc1);
+            acc2 = _mm256_fmadd_ps(v, _mm256_loadu_ps(w2 + i), acc2);
+        }
+
+        // Weights are padded, only the data needs a masked load
+        if (i < n) {
+            const __m256i mask = _mm256_loadu_si256(
+              reinterpret_cast<const __m256i *>(AVX2_MASKS + 8 - (n - i)));
+            const __m256 v = _mm256_maskload_ps(data + i, mask);
+
+            acc0 = _mm256_fmadd_ps(v, _mm256_loadu_ps(w0 + i), acc0);
+            acc1 = _mm256_fmadd_ps(v, _mm256_loadu_ps(w1 + i), acc1);
+            acc2 = _mm256_fmadd_ps(v, _mm256_loadu_ps(w2 + i), acc2);
+        }
+    }
+
+
+    template<size_t N>
+    SEXR_TARGET("avx2,fma")
+    static void avx2Kernel(
+      const BatchTerm *terms,
+      size_t           nTerms,
+      size_t           nPixels,
+      float            scale,
+      bool             clamp,
+      float *          out)
+    {
+        for (size_t p = 0; p < nPixels; p++) {
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            __m256 acc2 = _mm256_setzero_ps();
+
+            for (size_t t = 0; t < nTerms; t++) {
+                const BatchTerm &term = terms[t];
+                const float *    data = term.data + p * term.size;
+
+                if (N > 0 && term.size == N) {
+                    avx2Accumulate<N>(data, term.weights, N, acc0, acc1, acc2);
+                } else if (N > 1 && term.size == triangleSize(N)) {
+                    avx2Accumulate<triangleSize(N)>(
+                      data,
+                      term.weights,
+                      term.size,
+                      acc0,
+                      acc1,
+                      acc2);
+                } else {
+                    avx2Accumulate<0>(
+                      data,
+                      term.weights,
+                      term.size,
+                      acc0,
+                      acc1,
+                      acc2);
+                }
+            }
+
+            const __m128 sum = hsum3(
+              _mm_add_ps(
+                _mm256_castps256_ps128(acc0),
+                _mm256_extractf128_ps(acc0, 1)),
+              _mm_add_ps(
+                _mm256_castps256_ps128(acc1),
+                _mm256_extractf128_ps(acc1, 1)),
+              _mm_add_ps(
+                _mm256_castps256_ps128(acc2),
+                _mm256_extractf128_ps(acc2, 1)));
+
+            store3(sum, scale, clamp, out + 3 * p);
+        }
+    }
+
+
+    // Adds the four 128 bits lanes together. This goes through
+    // memory as GCC 12 lane extraction intrinsics trigger spurious
+    // -Wmaybe-uninitialized warnings
+    SEXR_TARGET("avx512f")
+    static inline __m128 fold128(__m512 v)
+    {
+        float lanes[16];
+        _mm512_storeu_ps(lanes, v);
+
+        const __m128 a
+          = _mm_add_ps(_mm_loadu_ps(lanes), _mm_loadu_ps(lanes + 4));
+        const __m128 b
+          = _mm_add_ps(_mm_loadu_ps(lanes + 8), _mm_loadu_ps(lanes + 12));
+
+        return _mm_add_ps(a, b);
+    }
+
+
+    template<size_t SIZE>
+    SEXR_TARGET("avx512f")
+    static inline void avx512Accumulate(
+      const float *data,
+      const float *weights,
+      size_t       size,
+      __m512 &     acc0,
+      __m512 &     acc1,
+      __m512 &     acc2)
+    {
+        const size_t n   = SIZE > 0 ? SIZE : size;
+        const size_t pad = SpectrumConverterKernels::paddedSize(n);
+
+        const float *w0 = weights;
+        const float *w1 = w0 + pad;
+        const float *w2 = w1 + pad;
+
+        size_t i = 0;
+
+        for (; i + 16 <= n; i += 16) {
+            const __m512 v = _mm512_loadu_ps(data + i);
+
+            acc0 = _mm512_fmadd_ps(v, _mm512_loadu_ps(w0 + i), acc0);
+            acc1 = _mm512_fmadd_ps(v, _mm512_loadu_ps(w1 + i), acc1);
+            acc2 = _mm512_fmadd_ps(v, _mm512_loadu_ps(w2 + i), acc2);
+        }
+
+        // Weights are padded, only the data needs a masked load
+        if (i < n) {
+            const __mmask16 mask
+              = static_cast<__mmask16>((1U << (n - i)) - 1U);
+            const __m512 v = _mm512_maskz_loadu_ps(mask, data + i);
+
+            acc0 = _mm512_fmadd_ps(v, _mm512_loadu_ps(w0 + i), acc0);
+            acc1 = _mm512_fmadd_ps(v, _mm512_loadu_ps(w1 + i), acc1);
+            acc2 = _mm512_fmadd_ps(v, _mm512_loadu_ps(w2 + i), acc2);
+        }
+    }
+
+
+    template<size_t N>
+    SEXR_TARGET("avx512f")
+    static void avx512Kernel(
+      const BatchTerm *terms,
+      size_t           nTerms,
+      size_t           nPixels,
+      float            scale,
+      bool             clamp,
+      float *          out)
+    {
+        for (size_t p = 0; p < nPixels; p++) {
+            __m512 acc0 = _mm512_setzero_ps();
+            __m512 acc1 = _mm512_setzero_ps();
+            __m512 acc2 = _mm512_setzero_ps();
+
+            for (size_t t = 0; t < nTerms; t++) {
+                const BatchTerm &term = terms[t];
+                const float *    data = term.data + p * term.size;
+
+                if (N > 0 && term.size == N) {
+                    avx512Accumulate<N>(
+                      data,
+                      term.weights,
+                      N,
+                      acc0,
+                      acc1,
+                      acc2);
+                } else if (N > 1 && term.size == triangleSize(N)) {
+                    avx512Accumulate<triangleSize(N)>(
+                      data,
+                      term.weights,
+                      term.size,
+                      acc0,
+                      acc1,
+                      acc2);
+                } else {
+                    avx512Accumulate<0>(
+                      data,
+                      term.weights,
+                      term.size,
+                      acc0,
+                      acc1,
+                      acc2);
+                }
+            }
+
+            const __m128 sum
+              = hsum3(fold128(acc0), fold128(acc1), fold128(acc2));
+
+            store3(sum, scale, clamp, out + 3 * p);
+        }
+    }
+#endif   // SEXR_X86_KERNELS
+
+
+    enum KernelISA
+    {
+        SCALAR_ISA,
+        SSE41_ISA,
+        AVX2_ISA,
+        AVX512_ISA
+    };
+
+
+    static KernelISA detectISA()
+    {
+#ifdef SEXR_X86_KERNELS
+        if (CpuFeatures::hasAVX512F()) return AVX512_ISA;
+        if (CpuFeatures::hasAVX2() && CpuFeatures::hasFMA()) return AVX2_ISA;
+        if (CpuFeatures::hasSSE41()) return SSE41_ISA;
+#endif
+        return SCALAR_ISA;
+    }
+
+
+    static KernelISA selectedISA()
+    {
+        static const KernelISA isa = detectISA();
+        return isa;
+    }
+
+
+    template<size_t N>
+    static BatchKernel isaKernel(KernelISA isa)
+    {
+        switch (isa) {
+#ifdef SEXR_X86_KERNELS
+            case AVX512_ISA:
+                return avx512Kernel<N>;
+            case AVX2_ISA:
+                return avx2Kernel<N>;
+            case SSE41_ISA:
+                return sse41Kernel<N>;
+#endif
+            default:
+                return scalarKernel<N>;
+        }
+    }
+
+
+    BatchKernel SpectrumConverterKernels::kernel()
+    {
+        return isaKernel<0>(selectedISA());
+    }
+
+
+    BatchKernel SpectrumConverterKernels::kernel(size_t nBands)
+    {
+        switch (nBands) {
+            // 400 nm to 700 nm by 10 nm steps
+            case 31:
+                return isaKernel<31>(selectedISA());
+            // Macbeth chart: 380 nm to 730 nm by 10 nm steps
+            case 36:
+                return isaKernel<36>(selectedISA());
+            // 380 nm to 780 nm by 10 nm steps (fluorescent samples)
+            case 41:
+                return isaKernel<41>(selectedISA());
+            default:
+                return kernel();
+        }
+    }
+
+
+    const char *SpectrumConverterKernels::kernelName()
+    {
+        switch (selectedISA()) {
+            case AVX512_ISA:
+                return "AVX-512";
+            case AVX2_ISA:
+                return "AVX2";
+            case SSE41_ISA:
+                return "SSE4.1";
+            default:
+                return "scalar";
+        }
+    }
+
+}   // namespace SEXR
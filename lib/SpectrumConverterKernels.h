@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace SEXR
+{
+    /**
+     * One term of a batch conversion. Each pixel stores `size`
+     * contiguous floats in `data` and is contracted against the
+     * three weight columns: weights[c * paddedSize(size) + i].
+     */
+    struct BatchTerm {
+        const float *data;
+        size_t       size;
+        const float *weights;
+    };
+
+    /**
+     * Converts nPixels pixels: for each pixel, the terms are summed
+     * in three accumulators, clamped to zero if clamp is set and
+     * multiplied by scale. out receives 3 floats per pixel.
+     */
+    typedef void (*BatchKernel)(
+      const BatchTerm *terms,
+      size_t           nTerms,
+      size_t           nPixels,
+      float            scale,
+      bool             clamp,
+      float *          out);
+
+    class SpectrumConverterKernels
+    {
+      public:
+        /**
+         * Number of floats each weight column is padded to so
+         * vector loads never read past the weights.
+         */
+        static constexpr size_t paddedSize(size_t size)
+        {
+            return (size + 15) & ~size_t(15);
+        }
+
+        /**
+         * Gets the fastest generic kernel supported by the running
+         * CPU. The detection is done once.
+         */
+        static BatchKernel kernel();
+
+        /**
+         * Gets a kernel for pixels with nBands spectral bands. Common
+         * band counts have kernels where the term sizes are compile
+         * time constants, other ones get the generic kernel.
+         *
+         * @param nBands number of spectral bands of the pixels. Each
+         * term holds either nBands values or the reradiation
+         * triangle.
+         */
+        static BatchKernel kernel(size_t nBands);
+
+        /** Gets the name of the instruction set kernel() uses. */
+        static const char *kernelName();
+    };
+
+}   // namespace SEXR
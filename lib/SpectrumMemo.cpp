@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SpectrumMemo.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SEXR
+{
+    const size_t SpectrumMemo::MAX_COMPONENTS;
+    const size_t SpectrumMemo::N_SHARDS;
+
+
+    SpectrumMemo::SpectrumMemo(size_t keySize, size_t memoryBudget)
+      : hits(0)
+      , misses(0)
+      , _keySize(keySize)
+      , _memoryBudget(memoryBudget)
+    {
+        // Key, value, hash and slot flag
+        const size_t entrySize
+          = (_keySize + 3) * sizeof(float) + sizeof(uint64_t) + 1;
+
+        _shardCapacity = std::max(
+          size_t(1),
+          _memoryBudget / (N_SHARDS * entrySize));
+    }
+
+
+    uint64_t SpectrumMemo::hash(const Pixel &pixel)
+    {
+        // The values are mixed in independent lanes so the compiler
+        // can vectorise the loop: hashing must stay cheaper than
+        // integrating the spectrum
+        uint32_t lanes[8] = {
+          0x9E3779B9U,
+          0x85EBCA6BU,
+          0xC2B2AE35U,
+          0x27D4EB2FU,
+          0x165667B1U,
+          0xD3A2646CU,
+          0xFD7046C5U,
+          0xB55A4F09U};
+
+        for (size_t c = 0; c < pixel.nComponents; c++) {
+            const float *data = pixel.data[c];
+            const size_t n    = pixel.size[c];
+            size_t       i    = 0;
+
+            for (; i + 8 <= n; i += 8) {
+                uint32_t words[8];
+                memcpy(words, &data[i], sizeof(words));
+
+                for (size_t l = 0; l < 8; l++) {
+                    lanes[l] = (lanes[l] ^ words[l]) * 0x01000193U;
+                    lanes[l] ^= lanes[l] >> 15;
+                }
+            }
+
+            for (; i < n; i++) {
+                uint32_t word;
+                memcpy(&word, &data[i], sizeof(word));
+
+                lanes[i % 8] = (lanes[i % 8] ^ word) * 0x01000193U;
+                lanes[i % 8] ^= lanes[i % 8] >> 15;
+            }
+        }
+
+        uint64_t h = 0xCBF29CE484222325ULL;
+
+        for (size_t l = 0; l < 8; l++) {
+            h = (h ^ lanes[l]) * 0x100000001B3ULL;
+        }
+
+        // Final avalanche so the shard, picked from the high bits, is
+        // well distributed
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+
+        return h;
+    }
+
+
+    bool SpectrumMemo::equal(const Pixel &a, const Pixel &b)
+    {
+        if (a.nComponents != b.nComponents) {
+            return false;
+        }
+
+        for (size_t c = 0; c < a.nComponents; c++) {
+            if (
+              a.size[c] != b.size[c]
+              || memcmp(a.data[c], b.data[c], a.size[c] * sizeof(float))
+                   != 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    bool SpectrumMemo::find(uint64_t hash, const Pixel &pixel, float rgb[3])
+    {
+        Shard &                     s = shard(hash);
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        const size_t e = slot(hash);
+
+        if (s.used.empty() || !s.used[e] || s.hashes[e] != hash) {
+            return false;
+        }
+
+        const float *key = &s.keys[e * _keySize];
+
+        for (size_t c = 0; c < pixel.nComponents; c++) {
+            if (
+              memcmp(key, pixel.data[c], pixel.size[c] * sizeof(float))
+              != 0) {
+                return false;
+            }
+
+            key += pixel.size[c];
+        }
+
+        memcpy(rgb, &s.rgb[3 * e], 3 * sizeof(float));
+
+        return true;
+    }
+
+
+    void SpectrumMemo::insert(
+      uint64_t hash, const Pixel &pixel, const float rgb[3])
+    {
+        Shard &                     s = shard(hash);
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        if (s.used.empty()) {
+            s.hashes.resize(_shardCapacity);
+            s.used.resize(_shardCapacity);
+            s.keys.resize(_shardCapacity * _keySize);
+            s.rgb.resize(3 * _shardCapacity);
+        }
+
+        const size_t e   = slot(hash);
+        float *      key = &s.keys[e * _keySize];
+
+        for (size_t c = 0; c < pixel.nComponents; c++) {
+            memcpy(key, pixel.data[c], pixel.size[c] * sizeof(float));
+            key += pixel.size[c];
+        }
+
+        memcpy(&s.rgb[3 * e], rgb, 3 * sizeof(float));
+        s.hashes[e] = hash;
+        s.used[e]   = 1;
+    }
+
+
+    void SpectrumMemo::clear()
+    {
+        for (Shard &s : _shards) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            std::fill(s.used.begin(), s.used.end(), 0);
+        }
+    }
+
+}   // namespace SEXR
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace SEXR
+{
+    /**
+     * Bounded memoisation of the RGB values of pixels. A pixel is
+     * described by up to 3 components (e.g. reflective, reradiation
+     * and emissive values) whose concatenation is the key; keys are
+     * compared bitwise so a hit always gives the value that would
+     * have been computed.
+     *
+     * Entries are spread over independently locked shards, each a
+     * direct mapped table allocated on its first insertion: a new
+     * entry replaces the one stored in its slot, so the footprint
+     * stays bounded without any allocation once the table exists.
+     * The hit rate tells whether the memoisation pays off.
+     */
+    class SpectrumMemo
+    {
+      public:
+        static const size_t MAX_COMPONENTS = 3;
+
+        struct Pixel
+        {
+            std::array<const float *, MAX_COMPONENTS> data;
+            std::array<size_t, MAX_COMPONENTS>        size;
+            size_t                                    nComponents;
+        };
+
+        /**
+         * @param keySize number of values describing a pixel.
+         * @param memoryBudget maximum number of bytes used by the
+         * entries.
+         */
+        SpectrumMemo(size_t keySize, size_t memoryBudget);
+
+        size_t keySize() const { return _keySize; }
+        size_t memoryBudget() const { return _memoryBudget; }
+
+        /** Hashes the values of a pixel. */
+        static uint64_t hash(const Pixel &pixel);
+
+        /** True if both pixels hold bitwise identical values. */
+        static bool equal(const Pixel &a, const Pixel &b);
+
+        /**
+         * Looks for the RGB value of a pixel.
+         *
+         * @returns true and fills rgb if the pixel is memoised.
+         */
+        bool find(uint64_t hash, const Pixel &pixel, float rgb[3]);
+
+        /** Memoises the RGB value of a pixel. */
+        void insert(uint64_t hash, const Pixel &pixel, const float rgb[3]);
+
+        /** Removes all the entries, the statistics are kept. */
+        void clear();
+
+        // Statistics, updated by the users of the memo
+        std::atomic<size_t> hits;
+        std::atomic<size_t> misses;
+
+      private:
+        static const size_t N_SHARDS = 16;
+
+        struct Shard
+        {
+            std::mutex            mutex;
+            std::vector<uint64_t> hashes;
+            std::vector<uint8_t>  used;
+            std::vector<float>    keys;
+            std::vector<float>    rgb;
+        };
+
+        Shard &shard(uint64_t hash) { return _shards[hash >> 60]; }
+
+        size_t slot(uint64_t hash) const { return hash % _shardCapacity; }
+
+        const size_t                _keySize;
+        const size_t                _memoryBudget;
+        size_t                      _shardCapacity;
+        std::array<Shard, N_SHARDS> _shards;
+    };
+
+}   // namespace SEXR
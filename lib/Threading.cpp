@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Threading.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <OpenEXR/ImfThreading.h>
+
+namespace SEXR
+{
+    static std::atomic<size_t> requestedThreadCount(0);
+    static std::atomic<bool>   threadCountSet(false);
+
+
+    void Threading::setThreadCount(size_t nThreads)
+    {
+        requestedThreadCount = nThreads;
+        threadCountSet       = true;
+
+        // The pool is only resized on request, never while the
+        // library decodes or encodes a file
+        Imf::setGlobalThreadCount(openEXRThreadCount());
+    }
+
+
+    size_t Threading::threadCount()
+    {
+        const size_t nThreads = requestedThreadCount;
+
+        if (nThreads > 0) {
+            return nThreads;
+        }
+
+        return std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+
+    int Threading::openEXRThreadCount()
+    {
+        // The pool of the application is used as is
+        if (!threadCountSet) {
+            return Imf::globalThreadCount();
+        }
+
+        const size_t nThreads = threadCount();
+
+        return nThreads > 1 ? static_cast<int>(nThreads) : 0;
+    }
+
+}   // namespace SEXR
@@ -37,7 +37,6 @@
 #pragma once
 
 #include <string>
-#include <map>
 #include <stdexcept>
 
 namespace SEXR
@@ -60,6 +59,42 @@ namespace SEXR
         static float lerp(float a, float b, float t) { return a + t * (b - a); }
 
 
+        /**
+         * Gets the multiplier of an SI prefix.
+         *
+         * @returns the multiplier, 0 if the prefix is unknown.
+         */
+        static double prefixMultiplier(const char *prefix, size_t length)
+        {
+            if (length == 2) {
+                return (prefix[0] == 'd' && prefix[1] == 'a') ? 1e1 : 0;
+            }
+
+            if (length != 1) {
+                return 0;
+            }
+
+            switch (prefix[0]) {
+                case 'Y': return 1e24;
+                case 'Z': return 1e21;
+                case 'E': return 1e18;
+                case 'P': return 1e15;
+                case 'T': return 1e12;
+                case 'G': return 1e9;
+                case 'M': return 1e6;
+                case 'k': return 1e3;
+                case 'h': return 1e2;
+                case 'd': return 1e-1;
+                case 'c': return 1e-2;
+                case 'm': return 1e-3;
+                case 'u': return 1e-6;
+                case 'n': return 1e-9;
+                case 'p': return 1e-12;
+                default: return 0;
+            }
+        }
+
+
         static double strToNanometers(
           const double &     value,
           const std::string &prefix,
@@ -69,27 +104,16 @@ namespace SEXR
 
             double wavelength_nm = value;
 
-            const std::map<std::string, double> unit_prefix = {
-              {"Y", 1e24},
-              {"Z", 1e21},
-              {"E", 1e18},
-              {"P", 1e15},
-              {"T", 1e12},
-              {"G", 1e9},
-              {"M", 1e6},
-              {"k", 1e3},
-              {"h", 1e2},
-              {"da", 1e1},
-              {"d", 1e-1},
-              {"c", 1e-2},
-              {"m", 1e-3},
-              {"u", 1e-6},
-              {"n", 1e-9},
-              {"p", 1e-12}};
-
             // Apply multiplier
             if (prefix.size() > 0) {
-                wavelength_nm *= unit_prefix.at(prefix);
+                const double multiplier
+                  = prefixMultiplier(prefix.c_str(), prefix.size());
+
+                if (multiplier == 0) {
+                    throw std::out_of_range("Unknown prefix");
+                }
+
+                wavelength_nm *= multiplier;
             }
 
             // Apply units
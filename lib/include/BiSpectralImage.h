@@ -75,15 +75,6 @@ namespace SEXR
          */
         virtual void exportChannels(const std::string &path) const;
 
-        /**
-         * Get the RGB version of the image. The rgb image is stored
-         * as rgbImage[3 * (row * width + col) + color].
-         *
-         * @param rgbImage a reference to the pointer where to store
-         * the RGB version of this bispectral image.
-         */
-        virtual void getRGBImage(std::vector<float> &rgbImage) const;
-
         /**
          * Number of elements needed to store the reradiation part of
          * the image.
@@ -155,6 +146,29 @@ namespace SEXR
 
 
       protected:
+        virtual void convertRGBSpan(
+          const SpectrumConverter &sc,
+          size_t                   x,
+          size_t                   y,
+          size_t                   n,
+          float *                  rgb) const;
+
+        virtual void convertXYZSpan(
+          const SpectrumConverter &sc,
+          size_t                   x,
+          size_t                   y,
+          size_t                   n,
+          float *                  xyz,
+          float                    scale) const;
+
+        virtual SpectrumType rgbConversionType() const;
+
+        virtual size_t pixelComponents(
+          size_t        x,
+          size_t        y,
+          const float **data,
+          size_t *      sizes) const;
+
         // Upper right triangular matrices for each pixel
         // pixel stride is reradiationSize()
         std::vector<float> _reradiation;
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace SEXR
+{
+    /**
+     * Describes an image computed by SpectralImage::getColorImages().
+     * Images are stored as image[nChannels() * (row * width + col) +
+     * channel].
+     */
+    class ColorOutput
+    {
+      public:
+        enum Type
+        {
+            XYZ,            // 3 channels
+            RGB,            // 3 linear channels, clamped to 0
+            LUMINANCE,      // 1 channel: Y
+            CHROMATICITY    // 2 channels: x, y
+        };
+
+        /**
+         * Creates an output of the given type. RGB outputs use the
+         * sRGB primaries.
+         */
+        ColorOutput(Type type = XYZ);
+
+        /**
+         * Creates a linear RGB output.
+         *
+         * @param xyzToRgb row major matrix converting XYZ to RGB.
+         */
+        ColorOutput(const std::array<float, 9> &xyzToRgb);
+
+        /** Linear sRGB / Rec.709 with a D65 white point. */
+        static ColorOutput sRGB();
+
+        /** Linear Rec.2020 with a D65 white point. */
+        static ColorOutput rec2020();
+
+        /** Linear ACEScg (AP1 primaries), adapted from D65. */
+        static ColorOutput ACEScg();
+
+        Type type() const { return _type; }
+
+        const std::array<float, 9> &matrix() const { return _matrix; }
+
+        /** Number of values per pixel. */
+        size_t nChannels() const;
+
+      protected:
+        Type                 _type;
+        std::array<float, 9> _matrix;
+    };
+
+}   // namespace SEXR
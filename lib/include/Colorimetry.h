@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace SEXR
+{
+    /**
+     * Catalogue of the standard observers and illuminants used to
+     * convert spectra to colours. Observers and illuminants are
+     * identified by an index: the built-in ones have fixed indices,
+     * the ones loaded at runtime get the next available index.
+     */
+    class Colorimetry
+    {
+      public:
+        enum Errors
+        {
+            READ_ERROR,
+            INCORRECT_FORMED_FILE,
+            INVALID_DATA,
+            INVALID_INDEX
+        };
+
+        enum BuiltinObservers
+        {
+            OBSERVER_CIE1931_2DEG,
+            OBSERVER_CIE1964_10DEG,
+
+            N_BUILTIN_OBSERVERS
+        };
+
+        enum BuiltinIlluminants
+        {
+            ILLUMINANT_D65,
+            ILLUMINANT_D50,
+            ILLUMINANT_D55,
+            ILLUMINANT_D75,
+            ILLUMINANT_A,
+            ILLUMINANT_E,
+            ILLUMINANT_F2,
+            ILLUMINANT_F7,
+            ILLUMINANT_F11,
+
+            N_BUILTIN_ILLUMINANTS
+        };
+
+        /**
+         * Loads colour matching functions from a CSV file. Each line
+         * holds a wavelength in nanometers followed by the x, y and z
+         * values (e.g. python/data/cmf/ciexyz31.csv). Lines that do
+         * not match are ignored.
+         *
+         * @param filename path of the CSV file.
+         * @return index of the new observer.
+         */
+        static size_t loadObserver(const std::string &filename);
+
+        /**
+         * Loads an illuminant spectral power distribution from a CSV
+         * file. Each line holds a wavelength in nanometers followed by
+         * the value. Lines that do not match are ignored.
+         *
+         * @param filename path of the CSV file.
+         * @return index of the new illuminant.
+         */
+        static size_t loadIlluminant(const std::string &filename);
+
+        /**
+         * Adds colour matching functions to the catalogue. They are
+         * resampled every nanometer.
+         *
+         * @param wavelengths_nm increasing wavelengths in nanometers.
+         * @param xyz x, y and z values for each wavelength.
+         * @return index of the new observer.
+         */
+        static size_t addObserver(
+          const std::vector<float> &               wavelengths_nm,
+          const std::array<std::vector<float>, 3> &xyz);
+
+        /**
+         * Adds an illuminant to the catalogue. It is resampled every
+         * nanometer.
+         *
+         * @param wavelengths_nm increasing wavelengths in nanometers.
+         * @param values spectral power distribution.
+         * @return index of the new illuminant.
+         */
+        static size_t addIlluminant(
+          const std::vector<float> &wavelengths_nm,
+          const std::vector<float> &values);
+
+        /** Gets the number of observers available. */
+        static size_t nObservers();
+
+        /** Gets the number of illuminants available. */
+        static size_t nIlluminants();
+
+        /**
+         * Sets the maximum number of bytes used by the conversion
+         * weights computed for each combination of wavelengths,
+         * spectrum type, observer and illuminant. These are shared
+         * by every image, the least recently used ones are dropped
+         * first. The default is 32 MiB.
+         *
+         * @param bytes memory budget in bytes. The most recently used
+         * weights are always kept.
+         */
+        static void setConverterCacheBudget(size_t bytes);
+
+        /** Gets the memory budget of the conversion weights. */
+        static size_t converterCacheBudget();
+
+        /** Gets the number of bytes used by the conversion weights. */
+        static size_t converterCacheUsage();
+    };
+
+}   // namespace SEXR
@@ -37,6 +37,8 @@
 #pragma once
 
 #include "BiSpectralImage.h"
+#include "LoadOptions.h"
+#include "SaveOptions.h"
 
 namespace SEXR
 {
@@ -62,8 +64,11 @@ namespace SEXR
          * Loads a spectral or bispectral image from an EXR file.
          *
          * @param filename path to the image to load.
+         * @param options options restricting what is loaded.
          */
-        EXRBiSpectralImage(const std::string &filename);
+        EXRBiSpectralImage(
+          const std::string &filename,
+          const LoadOptions &options = LoadOptions());
 
         /**
          * Saves the bispectral image to an EXR file.
@@ -72,6 +77,15 @@ namespace SEXR
          */
         void save(const std::string &filename) const;
 
+        /**
+         * Saves the image to an EXR file with the given layout.
+         *
+         * @param filename path where the image shall be saved.
+         * @param options layout of the file.
+         */
+        void
+        save(const std::string &filename, const SaveOptions &options) const;
+
         static SpectrumType channelType(
           const std::string &channelName,
           int &              polarisationComponent,
@@ -126,6 +140,11 @@ namespace SEXR
         static constexpr const char *EXPOSURE_COMPENSATION_ATTR = "EV";
         static constexpr const char *POLARISATION_HANDEDNESS_ATTR
           = "polarisationHandedness";
+        static constexpr const char *EMISSIVE_SCALE_ATTR = "emissiveScale";
+        static constexpr const char *REFLECTIVE_QUANTISATION_ATTR
+          = "reflectiveQuantisation";
+        static constexpr const char *RERADIATION_QUANTISATION_ATTR
+          = "reradiationQuantisation";
     };
 
 }   // namespace SEXR
@@ -41,6 +41,8 @@
 #include <string>
 
 #include "SpectralImage.h"
+#include "LoadOptions.h"
+#include "SaveOptions.h"
 
 namespace SEXR
 {
@@ -66,8 +68,11 @@ namespace SEXR
          * Loads a spectral image from an EXR file.
          *
          * @param filename path to the image to load.
+         * @param options options restricting what is loaded.
          */
-        EXRSpectralImage(const std::string &filename);
+        EXRSpectralImage(
+          const std::string &filename,
+          const LoadOptions &options = LoadOptions());
 
         /**
          * Saves the spectral image to an EXR file.
@@ -76,6 +81,15 @@ namespace SEXR
          */
         void save(const std::string &filename) const;
 
+        /**
+         * Saves the image to an EXR file with the given layout.
+         *
+         * @param filename path where the image shall be saved.
+         * @param options layout of the file.
+         */
+        void
+        save(const std::string &filename, const SaveOptions &options) const;
+
         static SpectrumType channelType(
           const std::string &channelName,
           int &              polarisationComponent,
@@ -113,6 +127,9 @@ namespace SEXR
         static constexpr const char *EXPOSURE_COMPENSATION_ATTR = "EV";
         static constexpr const char *POLARISATION_HANDEDNESS_ATTR
           = "polarisationHandedness";
+        static constexpr const char *EMISSIVE_SCALE_ATTR = "emissiveScale";
+        static constexpr const char *REFLECTIVE_QUANTISATION_ATTR
+          = "reflectiveQuantisation";
     };
 
 }   // namespace SEXR
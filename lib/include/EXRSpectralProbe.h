@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "SpectralImage.h"
+#include "SpectrumAttribute.h"
+#include "SpectrumType.h"
+
+namespace SEXR
+{
+    /**
+     * Describes a spectral EXR file from its header only. No pixel is
+     * read and no pixel buffer is allocated. The header is checked
+     * and parsed when the probe is created, a probe is then
+     * immutable and can be read from several threads.
+     */
+    class EXRSpectralProbe
+    {
+      public:
+        /**
+         * Creates an empty probe with an UNDEFINED spectrum type.
+         */
+        EXRSpectralProbe();
+
+        /**
+         * Reads the header of a spectral EXR file.
+         *
+         * @param filename path to the image to probe.
+         *
+         * @throws SpectralImage::INCORRECT_FORMED_FILE if the file has
+         * no spectral channel or is rejected by EXRSpectralImage and
+         * EXRBiSpectralImage, e.g. with inconsistent wavelengths or
+         * malformed attributes.
+         */
+        EXRSpectralProbe(const std::string &filename);
+
+        /**
+         * Probes several files in parallel, using
+         * Threading::threadCount() threads.
+         *
+         * @param filenames paths to the images to probe.
+         *
+         * @returns a probe per file, in the same order. The probe of a
+         * file which cannot be read or is not a spectral image has an
+         * UNDEFINED spectrum type.
+         */
+        static std::vector<EXRSpectralProbe>
+        probe(const std::vector<std::string> &filenames);
+
+        const std::string &filename() const { return _filename; }
+
+        size_t width() const { return _width; }
+        size_t height() const { return _height; }
+
+        SpectrumType spectrumType() const { return _spectrumType; }
+
+        bool isPolarised() const { return isPolarisedSpectrum(_spectrumType); }
+        bool isEmissive() const { return isEmissiveSpectrum(_spectrumType); }
+        bool isReflective() const
+        {
+            return isReflectiveSpectrum(_spectrumType);
+        }
+        bool isBispectral() const
+        {
+            return isBispectralSpectrum(_spectrumType);
+        }
+
+        SpectralImage::PolarisationHandedness polarisationHandedness() const
+        {
+            return _polarisationHandedness;
+        }
+
+        /** Sorted wavelengths of the spectral bands in nanometers. */
+        const std::vector<float> &wavelengths_nm() const
+        {
+            return _wavelengths_nm;
+        }
+
+        size_t nSpectralBands() const { return _wavelengths_nm.size(); }
+
+        /**
+         * Number of mipmap levels stored in the file, 1 for a file
+         * without levels. Each level can be loaded with
+         * LoadOptions::setLevel().
+         */
+        size_t nLevels() const { return _nLevels; }
+
+        /** Number of reradiation channels present in the file. */
+        size_t nReradiationChannels() const { return _nReradiationChannels; }
+
+        /**
+         * Gets the exposure compensation value, 0 when not specified.
+         */
+        float exposureCompensationValue() const { return _ev; }
+
+        /** Gets the lens transmission. Empty when not specified. */
+        const SpectrumAttribute &lensTransmission() const
+        {
+            return _lensTransmission;
+        }
+
+        /**
+         * Gets the camera spectral response. Empty when not specified.
+         */
+        const SpectrumAttribute &cameraResponse() const
+        {
+            return _cameraResponse;
+        }
+
+      protected:
+        /**
+         * Reads the header of a file, see EXRSpectralProbe(const
+         * std::string &).
+         *
+         * @param filename path to the image to probe.
+         * @param nThreads number of threads OpenEXR uses for the file.
+         */
+        EXRSpectralProbe(const std::string &filename, int nThreads);
+
+        std::string  _filename;
+        size_t       _width, _height;
+        SpectrumType _spectrumType;
+
+        SpectralImage::PolarisationHandedness _polarisationHandedness;
+
+        std::vector<float> _wavelengths_nm;
+        size_t             _nLevels;
+        size_t             _nReradiationChannels;
+        float              _ev;
+
+        SpectrumAttribute _lensTransmission;
+        SpectrumAttribute _cameraResponse;
+    };
+
+}   // namespace SEXR
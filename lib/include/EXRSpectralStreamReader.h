@@ -0,0 +1,273 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LoadOptions.h"
+#include "SpectrumType.h"
+
+namespace SEXR
+{
+    class EXRChannelReader;
+
+    /**
+     * Reads the emissive and reflective spectra of an EXR file by
+     * blocks of rows, without holding the whole image in memory. The
+     * blocks are decoded in a small ring of buffers: while a block is
+     * processed, the next ones are decoded in the background, and the
+     * memory used does not depend on the height of the image.
+     *
+     * The blocks are read in a single pass, either by calling next()
+     * until it returns nullptr, with forEachBlock(), or by iterating
+     * from begin() to end().
+     */
+    class EXRSpectralStreamReader
+    {
+      public:
+        /** Consecutive rows of the image. */
+        class Block
+        {
+          public:
+            /** Index of the first row of the block in the image. */
+            size_t y() const { return _y; }
+
+            size_t nRows() const { return _nRows; }
+
+            /**
+             * Spectrum of an emissive pixel.
+             *
+             * @param x column of the pixel.
+             * @param row row of the pixel in the block.
+             * @param stokesComponent Stokes component (0-3).
+             *
+             * @returns nSpectralBands() values, the pixels of the
+             * block follow each other row by row.
+             */
+            const float *
+            emissive(size_t x, size_t row, size_t stokesComponent = 0) const
+            {
+                return &_emissive[stokesComponent]
+                                 [(row * _width + x) * _nSpectralBands];
+            }
+
+            /**
+             * Spectrum of a reflective pixel, see emissive().
+             *
+             * @param x column of the pixel.
+             * @param row row of the pixel in the block.
+             */
+            const float *reflective(size_t x, size_t row) const
+            {
+                return &_reflective[(row * _width + x) * _nSpectralBands];
+            }
+
+          private:
+            friend class EXRSpectralStreamReader;
+
+            size_t _y, _nRows;
+            size_t _width, _nSpectralBands;
+
+            std::array<std::vector<float>, 4> _emissive;
+            std::vector<float>                _reflective;
+        };
+
+        /** Single pass iterator over the blocks. */
+        class BlockIterator
+        {
+          public:
+            typedef std::input_iterator_tag iterator_category;
+            typedef Block                   value_type;
+            typedef std::ptrdiff_t          difference_type;
+            typedef const Block *           pointer;
+            typedef const Block &           reference;
+
+            BlockIterator(): _stream(nullptr), _block(nullptr) {}
+
+            const Block &operator*() const { return *_block; }
+            const Block *operator->() const { return _block; }
+
+            BlockIterator &operator++()
+            {
+                _block = _stream->next();
+                return *this;
+            }
+
+            bool operator==(const BlockIterator &other) const
+            {
+                return _block == other._block;
+            }
+
+            bool operator!=(const BlockIterator &other) const
+            {
+                return _block != other._block;
+            }
+
+          private:
+            friend class EXRSpectralStreamReader;
+
+            BlockIterator(EXRSpectralStreamReader *stream, const Block *block)
+              : _stream(stream)
+              , _block(block)
+            {}
+
+            EXRSpectralStreamReader *_stream;
+            const Block *            _block;
+        };
+
+        /**
+         * Opens a spectral EXR file and reads its header.
+         *
+         * @param filename path to the image to read.
+         * @param options options restricting what is read.
+         * @param blockRows number of rows of a block. 0 aligns the
+         * blocks on the compression blocks or the tiles of the file.
+         * @param nBuffers number of blocks in memory, the block being
+         * processed and the blocks decoded ahead of it.
+         *
+         * @throws SpectralImage::INCORRECT_FORMED_FILE if the file has
+         * no spectral channel or inconsistent wavelengths.
+         * @throws SpectralImage::INVALID_OPTIONS if the options do not
+         * match the file.
+         */
+        EXRSpectralStreamReader(
+          const std::string &filename,
+          const LoadOptions &options   = LoadOptions(),
+          size_t             blockRows = 0,
+          size_t             nBuffers  = 2);
+
+        /** Waits for the blocks being decoded. */
+        ~EXRSpectralStreamReader();
+
+        EXRSpectralStreamReader(const EXRSpectralStreamReader &) = delete;
+        EXRSpectralStreamReader &
+        operator=(const EXRSpectralStreamReader &) = delete;
+
+        size_t width() const { return _width; }
+        size_t height() const { return _height; }
+
+        SpectrumType spectrumType() const { return _spectrumType; }
+
+        bool isPolarised() const { return isPolarisedSpectrum(_spectrumType); }
+        bool isEmissive() const { return isEmissiveSpectrum(_spectrumType); }
+        bool isReflective() const
+        {
+            return isReflectiveSpectrum(_spectrumType);
+        }
+
+        /** Number of Stokes components of the emissive spectra. */
+        size_t nStokesComponents() const
+        {
+            return isEmissive() ? (isPolarised() ? 4 : 1) : 0;
+        }
+
+        const std::vector<float> &wavelengths_nm() const
+        {
+            return _wavelengths_nm;
+        }
+
+        size_t nSpectralBands() const { return _wavelengths_nm.size(); }
+
+        /** Number of rows of the blocks, but the first and last ones. */
+        size_t blockRows() const { return _blockRows; }
+
+        size_t nBlocks() const { return _nBlocks; }
+
+        /**
+         * Gets the next block. The previous block is released and its
+         * buffer used to decode a next one.
+         *
+         * @returns the block, valid until the next call, or nullptr
+         * when every block was read.
+         *
+         * @throws SpectralImage::INCORRECT_FORMED_FILE or the OpenEXR
+         * exception raised when decoding the block.
+         */
+        const Block *next();
+
+        /**
+         * Calls a function on every remaining block, in order.
+         *
+         * @param callback function called with each block.
+         */
+        void forEachBlock(const std::function<void(const Block &)> &callback);
+
+        /** Gets the next block, see next(). */
+        BlockIterator begin() { return BlockIterator(this, next()); }
+        BlockIterator end() { return BlockIterator(); }
+
+      private:
+        struct Channel
+        {
+            std::string name;
+            float       scale;
+            float       offset;
+        };
+
+        /** Starts decoding a block after the previous ones. */
+        void schedule(size_t block);
+
+        /** Decodes a block in its buffer. */
+        void read(size_t block);
+
+        std::unique_ptr<EXRChannelReader> _reader;
+
+        size_t             _width, _height;
+        SpectrumType       _spectrumType;
+        std::vector<float> _wavelengths_nm;
+
+        // Rectangle of the file read, and first row of the first block
+        int _minX, _minY, _maxY, _firstBlockY;
+
+        size_t _blockRows, _nBlocks, _nextBlock;
+
+        std::array<std::vector<Channel>, 4> _emissiveChannels;
+        std::vector<Channel>                _reflectiveChannels;
+
+        std::vector<Block>                    _blocks;
+        std::vector<std::shared_future<void>> _reads;
+        std::shared_future<void>              _lastRead;
+    };
+
+}   // namespace SEXR
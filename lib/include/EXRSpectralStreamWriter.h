@@ -0,0 +1,198 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Colorimetry.h"
+#include "SaveOptions.h"
+#include "SpectralImage.h"
+#include "SpectrumAttribute.h"
+#include "SpectrumType.h"
+
+namespace SEXR
+{
+    class EXRChannelWriter;
+    class SpectrumConverter;
+
+    /**
+     * Writes a spectral EXR file by blocks of rows, as they are
+     * produced, without holding the whole image in memory. The
+     * metadata is given up front, and the RGB preview of each block
+     * is computed when the block is written.
+     *
+     * The file is a single part of scanlines written in increasing
+     * order. The values being unknown when the header is written,
+     * the emissive HALF scaling and the UINT quantisation are not
+     * supported.
+     */
+    class EXRSpectralStreamWriter
+    {
+      public:
+        /** Metadata of the image, see EXRSpectralImage. */
+        struct Metadata
+        {
+            Metadata()
+              : ev(0.F)
+              , handedness(SpectralImage::RIGHT_HANDED)
+              , observer(Colorimetry::OBSERVER_CIE1931_2DEG)
+              , illuminant(Colorimetry::ILLUMINANT_D65)
+            {}
+
+            SpectrumAttribute lensTransmission;
+            SpectrumAttribute cameraResponse;
+
+            /** Empty, or the sensitivity of each spectral band. */
+            std::vector<SpectrumAttribute> channelSensitivities;
+
+            /** Exposure compensation value, applied to the preview. */
+            float ev;
+
+            SpectralImage::PolarisationHandedness handedness;
+
+            /** Colour matching functions used by the preview. */
+            size_t observer;
+
+            /** Illuminant lighting the reflective part of the preview. */
+            size_t illuminant;
+        };
+
+        /**
+         * Creates the file and writes its header.
+         *
+         * @param filename path where the image shall be written.
+         * @param width width of the image.
+         * @param height height of the image.
+         * @param wavelengths_nm wavelengths in nanometers of the image.
+         * @param type emissive and / or reflective spectrum type.
+         * @param metadata metadata written in the header.
+         * @param options compression and types of the values.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if the image is
+         * empty, the type is bispectral or the options ask for tiles,
+         * parts, emissive scaling or quantised values.
+         * @throws Colorimetry::INVALID_INDEX if the observer or the
+         * illuminant is unknown.
+         */
+        EXRSpectralStreamWriter(
+          const std::string &       filename,
+          size_t                    width,
+          size_t                    height,
+          const std::vector<float> &wavelengths_nm,
+          SpectrumType              type,
+          const Metadata &          metadata = Metadata(),
+          const SaveOptions &       options  = SaveOptions());
+
+        /**
+         * Closes the file. If fewer rows than the height of the image
+         * were written, the missing rows cannot be read back.
+         */
+        ~EXRSpectralStreamWriter();
+
+        EXRSpectralStreamWriter(const EXRSpectralStreamWriter &) = delete;
+        EXRSpectralStreamWriter &
+        operator=(const EXRSpectralStreamWriter &) = delete;
+
+        size_t width() const { return _width; }
+        size_t height() const { return _height; }
+
+        SpectrumType spectrumType() const { return _spectrumType; }
+
+        bool isPolarised() const { return isPolarisedSpectrum(_spectrumType); }
+        bool isEmissive() const { return isEmissiveSpectrum(_spectrumType); }
+        bool isReflective() const
+        {
+            return isReflectiveSpectrum(_spectrumType);
+        }
+
+        /** Number of Stokes components of the emissive spectra. */
+        size_t nStokesComponents() const
+        {
+            return isEmissive() ? (isPolarised() ? 4 : 1) : 0;
+        }
+
+        const std::vector<float> &wavelengths_nm() const
+        {
+            return _wavelengths_nm;
+        }
+
+        size_t nSpectralBands() const { return _wavelengths_nm.size(); }
+
+        /** Index of the next row to write. */
+        size_t nextRow() const;
+
+        /** Whether every row of the image was written. */
+        bool isComplete() const { return nextRow() == _height; }
+
+        /**
+         * Writes the next rows of the image. The spectra of the
+         * nRows * width() pixels of the block follow each other row
+         * by row, with nSpectralBands() values per pixel.
+         *
+         * @param nRows number of rows to write.
+         * @param emissive spectra of each Stokes component, only the
+         * first nStokesComponents() are read.
+         * @param reflective reflective spectra, read if the image is
+         * reflective.
+         *
+         * @throws SpectralImage::INVALID_OPTIONS if a spectrum buffer
+         * is missing or the image has fewer rows left.
+         */
+        void writeRows(
+          size_t                             nRows,
+          const std::array<const float *, 4> &emissive,
+          const float *                      reflective = nullptr);
+
+      private:
+        std::unique_ptr<EXRChannelWriter> _writer;
+
+        size_t             _width, _height;
+        SpectrumType       _spectrumType;
+        std::vector<float> _wavelengths_nm;
+
+        std::shared_ptr<const SpectrumConverter> _converter;
+        float                                    _exposure;
+
+        // RGB preview of the block being written
+        std::vector<float> _rgb;
+    };
+
+}   // namespace SEXR
@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <SpectrumType.h>
+
+namespace SEXR
+{
+    /**
+     * Options restricting the part of a spectral EXR file which is
+     * loaded. By default, the whole file is loaded.
+     */
+    struct LoadOptions
+    {
+        LoadOptions()
+          : hasRegion(false)
+          , regionX(0)
+          , regionY(0)
+          , regionWidth(0)
+          , regionHeight(0)
+          , hasWavelengthRange(false)
+          , minWavelength_nm(0)
+          , maxWavelength_nm(0)
+          , components(EMISSIVE | POLARISED | BISPECTRAL)
+          , level(0)
+        {}
+
+        /**
+         * Restricts the loading to a rectangle of pixels. Only this
+         * rectangle is allocated and only the parts of the file
+         * overlapping it are read. The loaded image has the size of
+         * the rectangle.
+         *
+         * @param x column of the left of the rectangle, from the left
+         * of the image in the file.
+         * @param y row of the top of the rectangle, from the top of
+         * the image in the file.
+         * @param width width of the rectangle in pixels.
+         * @param height height of the rectangle in pixels.
+         */
+        void setRegion(size_t x, size_t y, size_t width, size_t height)
+        {
+            hasRegion    = true;
+            regionX      = x;
+            regionY      = y;
+            regionWidth  = width;
+            regionHeight = height;
+        }
+
+        /**
+         * Restricts the loading to the spectral bands within a range
+         * of wavelengths. Only the channels of these bands are read.
+         *
+         * @param min_nm lowest wavelength to load in nanometers.
+         * @param max_nm highest wavelength to load in nanometers.
+         */
+        void setWavelengthRange(float min_nm, float max_nm)
+        {
+            hasWavelengthRange = true;
+            minWavelength_nm   = min_nm;
+            maxWavelength_nm   = max_nm;
+        }
+
+        /**
+         * Restricts the loading to a list of spectral bands. Only the
+         * channels of these bands are read. Each wavelength must be
+         * present in the file.
+         *
+         * @param wavelengths_nm wavelengths of the bands to load in
+         * nanometers.
+         */
+        void setWavelengths(const std::vector<float> &wavelengths_nm)
+        {
+            wavelengthList_nm = wavelengths_nm;
+        }
+
+        /**
+         * Restricts the loading to some components of the image. The
+         * components of the file which are not listed are neither
+         * allocated nor read. For instance, EMISSIVE loads only the
+         * S0 channels and REFLECTIVE loads only the diagonal of the
+         * reflective part without the reradiation.
+         *
+         * @param loadedComponents combination of EMISSIVE, POLARISED,
+         * REFLECTIVE and BISPECTRAL. POLARISED is ignored without
+         * EMISSIVE.
+         */
+        void setComponents(SpectrumType loadedComponents)
+        {
+            components = loadedComponents;
+        }
+
+        /**
+         * Loads a mipmap level of a tiled file instead of its full
+         * resolution. The loaded image has the size of the level and
+         * the region, if any, is given in the coordinates of the
+         * level.
+         *
+         * @param mipmapLevel level to load. Level 0 is the full
+         * resolution, each level is half the size of the previous one.
+         */
+        void setLevel(size_t mipmapLevel) { level = mipmapLevel; }
+
+        bool   hasRegion;
+        size_t regionX;
+        size_t regionY;
+        size_t regionWidth;
+        size_t regionHeight;
+
+        bool               hasWavelengthRange;
+        float              minWavelength_nm;
+        float              maxWavelength_nm;
+        std::vector<float> wavelengthList_nm;
+
+        SpectrumType components;
+
+        size_t level;
+    };
+
+}   // namespace SEXR
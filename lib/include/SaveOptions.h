@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <OpenEXR/ImfCompression.h>
+#include <OpenEXR/ImfPixelType.h>
+#include <OpenEXR/ImfTileDescription.h>
+
+namespace SEXR
+{
+    /**
+     * Options controlling how a spectral EXR file is written. By
+     * default, the file is written as a single part of scanlines of
+     * FLOAT values.
+     */
+    struct SaveOptions
+    {
+        /** Parts of a multipart file, see setMultiPart(). */
+        enum Part
+        {
+            RGB_PART,            // RGB preview
+            S0_PART,             // First Stokes component
+            POLARISATION_PART,   // Other Stokes components
+            DIAGONAL_PART,       // Reflective channels
+            RERADIATION_PART,    // Reradiation channels
+            N_PARTS
+        };
+
+        /** Tiling and compression of a file or of a part. */
+        struct Layout
+        {
+            Layout()
+              : tiled(false)
+              , tileWidth(64)
+              , tileHeight(64)
+              , levelMode(Imf::ONE_LEVEL)
+              , compression(Imf::ZIP_COMPRESSION)
+              , compressionLevel(-1.F)
+            {}
+
+            /**
+             * Writes the pixels as tiles. Readers of a tiled file only
+             * decode the tiles overlapping the pixels they need.
+             *
+             * @param width width of a tile in pixels.
+             * @param height height of a tile in pixels.
+             * @param mode ONE_LEVEL to store the image only, or
+             * MIPMAP_LEVELS to also store downsampled versions of the
+             * image, each level half the size of the previous one.
+             */
+            void setTiles(
+              size_t         width,
+              size_t         height,
+              Imf::LevelMode mode = Imf::ONE_LEVEL)
+            {
+                tiled      = true;
+                tileWidth  = width;
+                tileHeight = height;
+                levelMode  = mode;
+            }
+
+            /** Writes the pixels as scanlines. */
+            void setScanlines() { tiled = false; }
+
+            /**
+             * Sets the compression of the pixels. The lossy methods
+             * (B44, B44A, DWAA, DWAB) only reduce HALF channels, FLOAT
+             * channels are stored losslessly.
+             *
+             * @param method compression method, ZIP_COMPRESSION by
+             * default.
+             * @param level compression level for the ZIP (1 to 9,
+             * OpenEXR 3.1 and later) and DWA (quality, 45 by default)
+             * methods. A negative value keeps the default level of
+             * OpenEXR.
+             */
+            void setCompression(Imf::Compression method, float level = -1.F)
+            {
+                compression      = method;
+                compressionLevel = level;
+            }
+
+            bool           tiled;
+            size_t         tileWidth;
+            size_t         tileHeight;
+            Imf::LevelMode levelMode;
+
+            Imf::Compression compression;
+            float            compressionLevel;
+        };
+
+        SaveOptions()
+          : multiPart(false)
+          , emissiveType(Imf::FLOAT)
+          , reflectiveType(Imf::FLOAT)
+          , reradiationType(Imf::FLOAT)
+          , scaleEmissive(false)
+        {}
+
+        /**
+         * Writes the file, or every part of a multipart file, as
+         * tiles. See Layout::setTiles().
+         */
+        void setTiles(
+          size_t         width,
+          size_t         height,
+          Imf::LevelMode mode = Imf::ONE_LEVEL)
+        {
+            layout.setTiles(width, height, mode);
+
+            for (Layout &l : partLayouts) {
+                l.setTiles(width, height, mode);
+            }
+        }
+
+        /**
+         * Sets the compression of the file, or of every part of a
+         * multipart file. See Layout::setCompression().
+         */
+        void setCompression(Imf::Compression method, float level = -1.F)
+        {
+            layout.setCompression(method, level);
+
+            for (Layout &l : partLayouts) {
+                l.setCompression(method, level);
+            }
+        }
+
+        /**
+         * Writes the preview, S0, S1 to S3, reflective and reradiation
+         * channels in separate parts of the file, so readers only
+         * decode the parts holding the channels they load. Each part
+         * can have its own layout, see partLayout().
+         *
+         * @param enable whether to write a multipart file.
+         */
+        void setMultiPart(bool enable) { multiPart = enable; }
+
+        /**
+         * Layout of a part of a multipart file. It is set by
+         * setTiles() and setCompression(): adjust the layouts of
+         * the parts after calling them.
+         *
+         * @param part part of the file.
+         */
+        Layout &partLayout(Part part) { return partLayouts[part]; }
+
+        /**
+         * Sets the type the spectral values are stored with. HALF
+         * values take half the space of FLOAT values but keep 11
+         * significant bits and range up to 65504, which suits
+         * reflectances and reradiation but may not suit emissive
+         * values, see setEmissiveScaling().
+         *
+         * UINT quantises the bounded reflective and reradiation values
+         * to 16 bits between the minimum and the maximum of the image.
+         * The scale and offset of the quantisation are stored in the
+         * file and the values are converted back on load.
+         *
+         * @param emissive type of the emissive channels, HALF or FLOAT.
+         * @param reflective type of the reflective channels, HALF,
+         * FLOAT or UINT.
+         * @param reradiation type of the reradiation channels of
+         * bispectral images, HALF, FLOAT or UINT.
+         */
+        void setPixelTypes(
+          Imf::PixelType emissive,
+          Imf::PixelType reflective,
+          Imf::PixelType reradiation)
+        {
+            emissiveType    = emissive;
+            reflectiveType  = reflective;
+            reradiationType = reradiation;
+        }
+
+        /**
+         * Divides each emissive band by a power of two so that its
+         * largest value lands just below 32768 when stored as HALF.
+         * This avoids overflows of HDR values and the precision loss
+         * of very small ones. The scales are stored in the file and
+         * applied back on load. Ignored for FLOAT emissive channels.
+         *
+         * @param enable whether to scale the emissive bands.
+         */
+        void setEmissiveScaling(bool enable) { scaleEmissive = enable; }
+
+        Layout layout;
+
+        bool                        multiPart;
+        std::array<Layout, N_PARTS> partLayouts;
+
+        Imf::PixelType emissiveType;
+        Imf::PixelType reflectiveType;
+        Imf::PixelType reradiationType;
+        bool           scaleEmissive;
+    };
+
+}   // namespace SEXR
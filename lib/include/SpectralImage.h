@@ -39,12 +39,21 @@
 #include <vector>
 #include <array>
 #include <string>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 
+#include <ColorOutput.h>
+#include <Colorimetry.h>
 #include <SpectrumAttribute.h>
 #include <SpectrumType.h>
 
 namespace SEXR
 {
+    class SpectrumConverter;
+    class SpectrumMemo;
+
     class SpectralImage
     {
       public:
@@ -54,7 +63,8 @@ namespace SEXR
             INTERNAL_ERROR,
             READ_ERROR,
             WRITE_ERROR,
-            INCORRECT_FORMED_FILE
+            INCORRECT_FORMED_FILE,
+            INVALID_OPTIONS
         };
 
         enum PolarisationHandedness
@@ -106,11 +116,68 @@ namespace SEXR
          * Get the RGB version of the image. The rgb image is stored
          * as rgbImage[3 * (row * width + col) + color].
          *
+         * The RGB version is cached: only the tiles modified through
+         * the writable emissive() and reflective() accessors since
+         * the last call are converted again. Note that calling a
+         * writable accessor marks its tile as modified even if it is
+         * only used for reading.
+         *
          * @param rgbImage a reference to the pointer where to store
          * the RGB version of this bispectral image.
          */
         virtual void getRGBImage(std::vector<float> &rgbImage) const;
 
+        /** Statistics of the memoised RGB conversion. */
+        struct MemoisationStats
+        {
+            size_t hits;
+            size_t misses;
+
+            /** Ratio of the converted pixels whose value was reused. */
+            float hitRate() const
+            {
+                return hits + misses > 0 ? float(hits) / float(hits + misses)
+                                         : 0.F;
+            }
+        };
+
+        /**
+         * Enables the reuse, by getRGBImage(), of the RGB values
+         * computed for pixels holding identical values. This pays off
+         * on images made of a few distinct spectra repeated over many
+         * pixels, such as charts or segmented images. The statistics
+         * are reset.
+         *
+         * @param enable true to enable the memoisation.
+         * @param memoryBudget maximum number of bytes used to store
+         * the memoised values.
+         */
+        void setRGBMemoisation(
+          bool enable, size_t memoryBudget = 16 * 1024 * 1024);
+
+        /** True if the RGB conversion is memoised. */
+        bool rgbMemoisation() const;
+
+        /**
+         * Gets the statistics of the memoised RGB conversion since it
+         * was enabled.
+         */
+        MemoisationStats rgbMemoisationStats() const;
+
+        /**
+         * Computes several colour versions of the image at once:
+         * each pixel is integrated once, then converted to every
+         * output. The exposure compensation applies to all outputs.
+         * The reradiation of bispectral images is taken into account.
+         *
+         * @param outputs description of the images to compute.
+         * @param images receives one image per output, stored as
+         * described by ColorOutput.
+         */
+        virtual void getColorImages(
+          const std::vector<ColorOutput> & outputs,
+          std::vector<std::vector<float>> &images) const;
+
         void setCameraResponse(
           const std::vector<float> &wavelengths_nm,
           const std::vector<float> &values);
@@ -165,6 +232,29 @@ namespace SEXR
          */
         const float &exposureCompensationValue() const;
 
+        /**
+         * Sets the observer used for the RGB representation.
+         *
+         * @param observer index of the colour matching functions in
+         * the Colorimetry catalogue.
+         */
+        void setObserver(size_t observer);
+
+        /** Gets the observer used by the RGB representation. */
+        size_t observer() const;
+
+        /**
+         * Sets the illuminant lighting the reflective part in the RGB
+         * representation.
+         *
+         * @param illuminant index of the illuminant in the
+         * Colorimetry catalogue.
+         */
+        void setIlluminant(size_t illuminant);
+
+        /** Gets the illuminant used by the RGB representation. */
+        size_t illuminant() const;
+
 
         // Access the emissive part
         virtual float &emissive(
@@ -256,9 +346,116 @@ namespace SEXR
         /** Spectrum type contains at each pixel location in the image */
         SpectrumType type() const;
 
+        /** Size in pixels of the tiles of the cached RGB version */
+        static const size_t PREVIEW_TILE_SIZE = 64;
+
       protected:
+        /**
+         * Converts a span of a row to RGB without exposure
+         * compensation.
+         *
+         * @param sc converter built for rgbConversionType().
+         * @param x column of the first pixel to convert.
+         * @param y row of the pixels to convert.
+         * @param n number of pixels to convert.
+         * @param rgb receives 3 * n RGB values.
+         */
+        virtual void convertRGBSpan(
+          const SpectrumConverter &sc,
+          size_t                   x,
+          size_t                   y,
+          size_t                   n,
+          float *                  rgb) const;
+
+        /**
+         * Integrates a span of a row to XYZ, see convertRGBSpan().
+         *
+         * @param sc converter built for rgbConversionType().
+         * @param x column of the first pixel to convert.
+         * @param y row of the pixels to convert.
+         * @param n number of pixels to convert.
+         * @param xyz receives 3 * n XYZ values.
+         * @param scale factor applied to the XYZ values.
+         */
+        virtual void convertXYZSpan(
+          const SpectrumConverter &sc,
+          size_t                   x,
+          size_t                   y,
+          size_t                   n,
+          float *                  xyz,
+          float                    scale) const;
+
+        /** Spectrum type the colour conversions need weights for. */
+        virtual SpectrumType rgbConversionType() const;
+
+        /**
+         * Gives the values used by the RGB conversion of a pixel, as
+         * up to 3 arrays.
+         *
+         * @param x column of the pixel.
+         * @param y row of the pixel.
+         * @param data receives the address of each array.
+         * @param sizes receives the number of values of each array.
+         *
+         * @returns the number of arrays.
+         */
+        virtual size_t pixelComponents(
+          size_t        x,
+          size_t        y,
+          const float **data,
+          size_t *      sizes) const;
+
+        // Same as convertRGBSpan() reusing the values of identical
+        // pixels. hashes is a scratch buffer the caller keeps across
+        // spans to avoid an allocation per span
+        void convertRGBSpanMemoised(
+          const SpectrumConverter &sc,
+          SpectrumMemo &           memo,
+          size_t                   x,
+          size_t                   y,
+          size_t                   n,
+          float *                  rgb,
+          std::vector<uint64_t> &  hashes) const;
+
+        /**
+         * Marks the tile of the cached RGB version containing the
+         * given pixel as outdated.
+         */
+        void invalidatePreview(size_t x, size_t y) const
+        {
+            const size_t tile = (y / PREVIEW_TILE_SIZE) * previewTilesX()
+                                + x / PREVIEW_TILE_SIZE;
+
+            _preview.dirty[tile].store(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * Marks the whole cached RGB version as outdated. Must be
+         * called when the image size changes.
+         */
+        void invalidatePreview() const;
+
+        size_t previewTilesX() const
+        {
+            return (_width + PREVIEW_TILE_SIZE - 1) / PREVIEW_TILE_SIZE;
+        }
+
+        size_t previewTilesY() const
+        {
+            return (_height + PREVIEW_TILE_SIZE - 1) / PREVIEW_TILE_SIZE;
+        }
+
+        // Converts a row of XYZ values to each of the outputs
+        void writeColorOutputs(
+          const std::vector<ColorOutput> & outputs,
+          const float *                    xyz,
+          size_t                           y,
+          std::vector<std::vector<float>> &images) const;
+
         size_t _width, _height;
         float  _ev;
+        size_t _observer;
+        size_t _illuminant;
 
         // We can have up to 6 pixel buffers:
         // - 1 for emissive unpolarised images (S0)
@@ -276,6 +473,28 @@ namespace SEXR
         SpectrumAttribute              _lensTransmissionSpectra;
         SpectrumAttribute              _cameraReponse;
         std::vector<SpectrumAttribute> _channelSensitivities;
+
+        // Cached RGB version of the image, without exposure
+        // compensation, and a flag per tile telling whether it is
+        // outdated
+        struct PreviewCache
+        {
+            PreviewCache();
+            PreviewCache(const PreviewCache &other);
+            PreviewCache &operator=(const PreviewCache &other);
+            ~PreviewCache();
+
+            std::vector<float>                rgb;
+            std::vector<std::atomic<uint8_t>> dirty;
+            std::mutex                        mutex;
+
+            // Memoisation is disabled when the budget is 0, the memo
+            // is created on the first conversion
+            size_t                        memoBudget;
+            std::unique_ptr<SpectrumMemo> memo;
+        };
+
+        mutable PreviewCache _preview;
     };
 
 }   // namespace SEXR
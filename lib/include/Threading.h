@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace SEXR
+{
+    class Threading
+    {
+      public:
+        /**
+         * Sets the number of threads the library may use for its
+         * image wide operations (e.g. RGB conversion) and to decode
+         * and encode the chunks of the files it reads and writes.
+         * The global thread pool of OpenEXR is resized to it, so this
+         * shall not be called while files are being read or written.
+         * Until this is called, the pool is left as the application
+         * set it.
+         *
+         * @param nThreads maximum number of threads. 0 uses one
+         * thread per hardware thread available.
+         */
+        static void setThreadCount(size_t nThreads);
+
+        /**
+         * Gets the number of threads the library uses. This is
+         * always at least 1.
+         */
+        static size_t threadCount();
+
+        /**
+         * Gets the number of threads to pass to the OpenEXR files:
+         * the count set by setThreadCount(), or the size of the
+         * global thread pool of OpenEXR if it was never called. With
+         * a single thread, 0 is returned: the chunks are then decoded
+         * in the calling thread.
+         */
+        static int openEXRThreadCount();
+    };
+
+}   // namespace SEXR
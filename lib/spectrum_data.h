@@ -50,6 +50,32 @@ namespace SEXR
       1.0572252F,
     };
 
+    const float XYZ_TO_REC2020_D65_MATRIX[9] = {
+      1.7166512F,
+      -0.3556708F,
+      -0.2533663F,
+      -0.6666844F,
+      1.6164812F,
+      0.0157685F,
+      0.0176399F,
+      -0.0427706F,
+      0.9421031F,
+    };
+
+    // AP1 primaries, from D65 with a Bradford adaptation to the ACES
+    // white point
+    const float XYZ_TO_ACESCG_D65_MATRIX[9] = {
+      1.6605853F,
+      -0.3152956F,
+      -0.2415093F,
+      -0.6599261F,
+      1.6083915F,
+      0.0172986F,
+      0.0090026F,
+      -0.0035669F,
+      0.9136433F,
+    };
+
     const float CIE1931_2DEG_FIRST_WAVELENGTH_NM = 360.F;
 
     const float CIE1931_2DEG_X[]
@@ -524,4 +550,695 @@ namespace SEXR
 
     const float D_65_FIRST_WAVELENGTH_NM = 300.F;
 
+    // CIE daylight components, 300 nm to 830 nm by steps of 10 nm.
+    // D series illuminants are S0 + M1 * S1 + M2 * S2 where M1 and M2
+    // derive from the correlated colour temperature.
+    const float CIE_DAYLIGHT_FIRST_WAVELENGTH_NM = 300.F;
+    const float CIE_DAYLIGHT_WAVELENGTH_STEP_NM  = 10.F;
+
+    const float CIE_DAYLIGHT_S0[54] = {
+      0.04F,
+      6.00F,
+      29.60F,
+      55.30F,
+      57.30F,
+      61.80F,
+      61.50F,
+      68.80F,
+      63.40F,
+      65.80F,
+      94.80F,
+      104.80F,
+      105.90F,
+      96.80F,
+      113.90F,
+      125.60F,
+      125.50F,
+      121.30F,
+      121.30F,
+      113.50F,
+      113.10F,
+      110.80F,
+      106.50F,
+      108.80F,
+      105.30F,
+      104.40F,
+      100.00F,
+      96.00F,
+      95.10F,
+      89.10F,
+      90.50F,
+      90.30F,
+      88.40F,
+      84.00F,
+      85.10F,
+      81.90F,
+      82.60F,
+      84.90F,
+      81.30F,
+      71.90F,
+      74.30F,
+      76.40F,
+      63.30F,
+      71.70F,
+      77.00F,
+      65.20F,
+      47.70F,
+      68.60F,
+      65.00F,
+      66.00F,
+      61.00F,
+      53.30F,
+      58.90F,
+      61.90F,
+    };
+
+    const float CIE_DAYLIGHT_S1[54] = {
+      0.02F,
+      4.50F,
+      22.40F,
+      42.00F,
+      40.60F,
+      41.60F,
+      38.00F,
+      42.40F,
+      38.50F,
+      35.00F,
+      43.40F,
+      46.30F,
+      43.90F,
+      37.10F,
+      36.70F,
+      35.90F,
+      32.60F,
+      27.90F,
+      24.30F,
+      20.10F,
+      16.20F,
+      13.20F,
+      8.60F,
+      6.10F,
+      4.20F,
+      1.90F,
+      0.00F,
+      -1.60F,
+      -3.50F,
+      -3.50F,
+      -5.80F,
+      -7.20F,
+      -8.60F,
+      -9.50F,
+      -10.90F,
+      -10.70F,
+      -12.00F,
+      -14.00F,
+      -13.60F,
+      -12.00F,
+      -13.30F,
+      -12.90F,
+      -10.60F,
+      -11.60F,
+      -12.20F,
+      -10.20F,
+      -7.80F,
+      -11.20F,
+      -10.40F,
+      -10.60F,
+      -9.70F,
+      -8.30F,
+      -9.30F,
+      -9.80F,
+    };
+
+    const float CIE_DAYLIGHT_S2[54] = {
+      0.00F,
+      2.00F,
+      4.00F,
+      8.50F,
+      7.80F,
+      6.70F,
+      5.30F,
+      6.10F,
+      3.00F,
+      1.20F,
+      -1.10F,
+      -0.50F,
+      -0.70F,
+      -1.20F,
+      -2.60F,
+      -2.90F,
+      -2.80F,
+      -2.60F,
+      -2.60F,
+      -1.80F,
+      -1.50F,
+      -1.30F,
+      -1.20F,
+      -1.00F,
+      -0.50F,
+      -0.30F,
+      0.00F,
+      0.20F,
+      0.50F,
+      2.10F,
+      3.20F,
+      4.10F,
+      4.70F,
+      5.10F,
+      6.70F,
+      7.30F,
+      8.60F,
+      9.80F,
+      10.20F,
+      8.30F,
+      9.60F,
+      8.50F,
+      7.00F,
+      7.60F,
+      8.00F,
+      6.70F,
+      5.20F,
+      7.40F,
+      6.80F,
+      7.00F,
+      6.40F,
+      5.50F,
+      6.10F,
+      6.50F,
+    };
+
+    // CIE 1964 10° standard observer, 380 nm to 780 nm by steps of 5 nm
+    const float CIE1964_10DEG_FIRST_WAVELENGTH_NM = 380.F;
+    const float CIE1964_10DEG_WAVELENGTH_STEP_NM  = 5.F;
+
+    const float CIE1964_10DEG_X[81] = {
+      0.000160F,
+      0.000662F,
+      0.002362F,
+      0.007242F,
+      0.019110F,
+      0.043400F,
+      0.084736F,
+      0.140638F,
+      0.204492F,
+      0.264737F,
+      0.314679F,
+      0.357719F,
+      0.383734F,
+      0.386726F,
+      0.370702F,
+      0.342957F,
+      0.302273F,
+      0.254085F,
+      0.195618F,
+      0.132349F,
+      0.080507F,
+      0.041072F,
+      0.016172F,
+      0.005132F,
+      0.003816F,
+      0.015444F,
+      0.037465F,
+      0.071358F,
+      0.117749F,
+      0.172953F,
+      0.236491F,
+      0.304213F,
+      0.376772F,
+      0.451584F,
+      0.529826F,
+      0.616053F,
+      0.705224F,
+      0.793832F,
+      0.878655F,
+      0.951162F,
+      1.014160F,
+      1.074300F,
+      1.118520F,
+      1.134300F,
+      1.123990F,
+      1.089100F,
+      1.030480F,
+      0.950740F,
+      0.856297F,
+      0.754930F,
+      0.647467F,
+      0.535110F,
+      0.431567F,
+      0.343690F,
+      0.268329F,
+      0.204300F,
+      0.152568F,
+      0.112210F,
+      0.081261F,
+      0.057930F,
+      0.040851F,
+      0.028623F,
+      0.019941F,
+      0.013842F,
+      0.009577F,
+      0.006605F,
+      0.004553F,
+      0.003145F,
+      0.002175F,
+      0.001506F,
+      0.001045F,
+      0.000727F,
+      0.000508F,
+      0.000356F,
+      0.000251F,
+      0.000178F,
+      0.000126F,
+      0.000090F,
+      0.000065F,
+      0.000046F,
+      0.000033F,
+    };
+
+    const float CIE1964_10DEG_Y[81] = {
+      0.000017F,
+      0.000072F,
+      0.000253F,
+      0.000769F,
+      0.002004F,
+      0.004509F,
+      0.008756F,
+      0.014456F,
+      0.021391F,
+      0.029497F,
+      0.038676F,
+      0.049602F,
+      0.062077F,
+      0.074704F,
+      0.089456F,
+      0.106256F,
+      0.128201F,
+      0.152761F,
+      0.185190F,
+      0.219940F,
+      0.253589F,
+      0.297665F,
+      0.339133F,
+      0.395379F,
+      0.460777F,
+      0.531360F,
+      0.606741F,
+      0.685660F,
+      0.761757F,
+      0.823330F,
+      0.875211F,
+      0.923810F,
+      0.961988F,
+      0.982200F,
+      0.991761F,
+      0.999110F,
+      0.997340F,
+      0.982380F,
+      0.955552F,
+      0.915175F,
+      0.868934F,
+      0.825623F,
+      0.777405F,
+      0.720353F,
+      0.658341F,
+      0.593878F,
+      0.527963F,
+      0.461834F,
+      0.398057F,
+      0.339554F,
+      0.283493F,
+      0.228254F,
+      0.179828F,
+      0.140211F,
+      0.107633F,
+      0.081187F,
+      0.060281F,
+      0.044096F,
+      0.031800F,
+      0.022602F,
+      0.015905F,
+      0.011130F,
+      0.007749F,
+      0.005375F,
+      0.003718F,
+      0.002565F,
+      0.001768F,
+      0.001222F,
+      0.000846F,
+      0.000586F,
+      0.000407F,
+      0.000284F,
+      0.000199F,
+      0.000140F,
+      0.000098F,
+      0.000070F,
+      0.000050F,
+      0.000036F,
+      0.000025F,
+      0.000018F,
+      0.000013F,
+    };
+
+    const float CIE1964_10DEG_Z[81] = {
+      0.000705F,
+      0.002928F,
+      0.010482F,
+      0.032344F,
+      0.086011F,
+      0.197120F,
+      0.389366F,
+      0.656760F,
+      0.972542F,
+      1.282500F,
+      1.553480F,
+      1.798500F,
+      1.967280F,
+      2.027300F,
+      1.994800F,
+      1.900700F,
+      1.745370F,
+      1.554900F,
+      1.317560F,
+      1.030200F,
+      0.772125F,
+      0.570060F,
+      0.415254F,
+      0.302356F,
+      0.218502F,
+      0.159249F,
+      0.112044F,
+      0.082248F,
+      0.060709F,
+      0.043050F,
+      0.030451F,
+      0.020584F,
+      0.013676F,
+      0.007918F,
+      0.003988F,
+      0.001091F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+      0.000000F,
+    };
+
+    // CIE fluorescent illuminants F2 (cool white), F7 (broadband
+    // daylight) and F11 (narrow tri-band), 380 nm to 780 nm by steps
+    // of 5 nm
+    const float CIE_F_FIRST_WAVELENGTH_NM = 380.F;
+    const float CIE_F_WAVELENGTH_STEP_NM  = 5.F;
+
+    const float CIE_F2_SPD[81] = {
+      1.18F,
+      1.48F,
+      1.84F,
+      2.15F,
+      3.44F,
+      15.69F,
+      3.85F,
+      3.74F,
+      4.19F,
+      4.62F,
+      5.06F,
+      34.98F,
+      11.81F,
+      6.27F,
+      6.63F,
+      6.93F,
+      7.19F,
+      7.40F,
+      7.54F,
+      7.62F,
+      7.65F,
+      7.62F,
+      7.62F,
+      7.45F,
+      7.28F,
+      7.15F,
+      7.05F,
+      7.04F,
+      7.16F,
+      7.47F,
+      8.04F,
+      8.88F,
+      10.01F,
+      24.88F,
+      16.64F,
+      14.59F,
+      16.16F,
+      17.56F,
+      18.62F,
+      21.47F,
+      22.79F,
+      19.29F,
+      18.66F,
+      17.73F,
+      16.54F,
+      15.21F,
+      13.80F,
+      12.36F,
+      10.95F,
+      9.65F,
+      8.40F,
+      7.32F,
+      6.31F,
+      5.43F,
+      4.68F,
+      4.02F,
+      3.45F,
+      2.96F,
+      2.55F,
+      2.19F,
+      1.89F,
+      1.64F,
+      1.53F,
+      1.27F,
+      1.10F,
+      0.99F,
+      0.88F,
+      0.76F,
+      0.68F,
+      0.61F,
+      0.56F,
+      0.54F,
+      0.51F,
+      0.47F,
+      0.47F,
+      0.43F,
+      0.46F,
+      0.47F,
+      0.40F,
+      0.33F,
+      0.27F,
+    };
+
+    const float CIE_F7_SPD[81] = {
+      2.56F,
+      3.18F,
+      3.84F,
+      4.53F,
+      6.15F,
+      19.37F,
+      7.37F,
+      7.05F,
+      7.71F,
+      8.41F,
+      9.15F,
+      44.14F,
+      17.52F,
+      11.35F,
+      12.00F,
+      12.58F,
+      13.08F,
+      13.45F,
+      13.71F,
+      13.88F,
+      13.95F,
+      13.93F,
+      13.82F,
+      13.64F,
+      13.43F,
+      13.25F,
+      13.08F,
+      12.93F,
+      12.78F,
+      12.60F,
+      12.44F,
+      12.33F,
+      12.26F,
+      29.52F,
+      17.05F,
+      12.44F,
+      12.58F,
+      12.72F,
+      12.83F,
+      15.46F,
+      16.75F,
+      12.83F,
+      12.67F,
+      12.45F,
+      12.19F,
+      11.89F,
+      11.60F,
+      11.35F,
+      11.12F,
+      10.95F,
+      10.76F,
+      10.42F,
+      10.11F,
+      10.04F,
+      10.02F,
+      10.11F,
+      9.87F,
+      8.65F,
+      7.27F,
+      6.44F,
+      5.83F,
+      5.41F,
+      5.04F,
+      4.57F,
+      4.12F,
+      3.77F,
+      3.46F,
+      3.08F,
+      2.73F,
+      2.47F,
+      2.25F,
+      2.06F,
+      1.90F,
+      1.75F,
+      1.62F,
+      1.54F,
+      1.45F,
+      1.32F,
+      1.17F,
+      0.99F,
+      0.81F,
+    };
+
+    const float CIE_F11_SPD[81] = {
+      0.91F,
+      0.63F,
+      0.46F,
+      0.37F,
+      1.29F,
+      12.68F,
+      1.59F,
+      1.79F,
+      2.46F,
+      3.33F,
+      4.49F,
+      33.94F,
+      12.13F,
+      6.95F,
+      7.19F,
+      7.12F,
+      6.72F,
+      6.13F,
+      5.46F,
+      4.79F,
+      5.66F,
+      14.29F,
+      14.96F,
+      8.97F,
+      4.72F,
+      2.33F,
+      1.47F,
+      1.10F,
+      0.89F,
+      0.83F,
+      1.18F,
+      4.90F,
+      39.59F,
+      72.84F,
+      32.61F,
+      7.52F,
+      2.83F,
+      1.96F,
+      1.67F,
+      4.43F,
+      11.28F,
+      14.76F,
+      12.73F,
+      9.74F,
+      7.33F,
+      9.72F,
+      55.27F,
+      42.58F,
+      13.18F,
+      13.16F,
+      12.26F,
+      5.11F,
+      2.07F,
+      2.34F,
+      3.58F,
+      3.01F,
+      2.48F,
+      2.14F,
+      1.54F,
+      1.33F,
+      1.46F,
+      1.94F,
+      2.00F,
+      1.20F,
+      1.35F,
+      4.10F,
+      5.58F,
+      2.51F,
+      0.57F,
+      0.27F,
+      0.23F,
+      0.21F,
+      0.24F,
+      0.24F,
+      0.20F,
+      0.24F,
+      0.32F,
+      0.26F,
+      0.16F,
+      0.12F,
+      0.09F,
+    };
+
 }   // namespace SEXR
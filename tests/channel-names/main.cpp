@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Parses and formats spectral channel names, including the spellings
+// that differ only by how a prefix or an exponent is read
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "EXRChannelName.h"
+
+using namespace SEXR;
+
+int nFailures = 0;
+
+#define CHECK(condition)                                         \
+    do {                                                         \
+        if (!(condition)) {                                      \
+            std::fprintf(                                        \
+              stderr,                                            \
+              "%s:%d: %s\n",                                     \
+              __FILE__,                                          \
+              __LINE__,                                          \
+              #condition);                                       \
+            nFailures++;                                         \
+        }                                                        \
+    } while (0)
+
+
+struct ParseCase
+{
+    std::string  name;
+    SpectrumType type;
+    int          polarisationComponent;
+    double       wavelength_nm;
+    double       reradiation_wavelength_nm;
+};
+
+
+bool nearlyEqual(double a, double b)
+{
+    return std::abs(a - b) <= 1e-6 * std::abs(b);
+}
+
+
+void testParse()
+{
+    const double       c = 299792458.;
+    const SpectrumType POLARISED
+      = SpectrumType::EMISSIVE | SpectrumType::POLARISED;
+
+    const std::vector<ParseCase> cases = {
+      {"S0.500nm", SpectrumType::EMISSIVE, 0, 500., 0.},
+      // Decimal comma and exponent
+      {"S3.5,5E2nm", POLARISED, 3, 550., 0.},
+      {"T.5e+2nm", SpectrumType::REFLECTIVE, 0, 500., 0.},
+      {"T.,5um", SpectrumType::REFLECTIVE, 0, 500., 0.},
+      // E without digits is the exa prefix, not an exponent
+      {"T.1Em", SpectrumType::REFLECTIVE, 0, 1e27, 0.},
+      // da is the deca prefix
+      {"S1.500dam", POLARISED, 1, 5e12, 0.},
+      {"T.600THz", SpectrumType::REFLECTIVE, 0, c / 600e12 * 1e9, 0.},
+      {"T.500nm.6E2nm", SpectrumType::BISPECTRAL, 0, 500., 600.},
+      {"T.500nm.600Hz", SpectrumType::BISPECTRAL, 0, 500., c / 600. * 1e9},
+      // Not spectral channels
+      {"R", SpectrumType::UNDEFINED, 0, 0., 0.},
+      {"T.nm", SpectrumType::UNDEFINED, 0, 0., 0.},
+      {"S4.500nm", SpectrumType::UNDEFINED, 0, 0., 0.},
+      {"T.500", SpectrumType::UNDEFINED, 0, 0., 0.},
+      {"T.500nm.", SpectrumType::UNDEFINED, 0, 0., 0.},
+      {"T.500xm", SpectrumType::UNDEFINED, 0, 0., 0.},
+      {"Tx.500nm", SpectrumType::UNDEFINED, 0, 0., 0.},
+      {"S0.500nm.600nm", SpectrumType::UNDEFINED, 0, 0., 0.}};
+
+    for (const ParseCase &expected : cases) {
+        int    polarisationComponent     = 0;
+        double wavelength_nm             = 0;
+        double reradiation_wavelength_nm = 0;
+
+        const SpectrumType type = EXRChannelName::parse(
+          expected.name,
+          polarisationComponent,
+          wavelength_nm,
+          reradiation_wavelength_nm);
+
+        if (type != expected.type) {
+            std::fprintf(stderr, "Wrong type for %s\n", expected.name.c_str());
+            nFailures++;
+            continue;
+        }
+
+        if (type == SpectrumType::UNDEFINED) {
+            continue;
+        }
+
+        CHECK(polarisationComponent == expected.polarisationComponent);
+        CHECK(nearlyEqual(wavelength_nm, expected.wavelength_nm));
+
+        if (type == SpectrumType::BISPECTRAL) {
+            CHECK(nearlyEqual(
+              reradiation_wavelength_nm,
+              expected.reradiation_wavelength_nm));
+        }
+    }
+}
+
+
+void testFormat()
+{
+    // Values are written with %f and a decimal comma
+    CHECK(EXRChannelName::emissive(0, 500.) == "S0.500,000000nm");
+    CHECK(EXRChannelName::emissive(3, 550.25) == "S3.550,250000nm");
+    CHECK(EXRChannelName::reflective(404.25) == "T.404,250000nm");
+    CHECK(EXRChannelName::reflective(1e-7) == "T.0,000000nm");
+    CHECK(
+      EXRChannelName::reradiation(400., 612.5)
+      == "T.400,000000nm.612,500000nm");
+}
+
+
+void testRoundTrip()
+{
+    for (size_t i = 0; i < 100; i++) {
+        const double wavelength_nm = 380. + 4.25 * i;
+        const double reemission_nm = wavelength_nm + 12.5;
+
+        int    polarisationComponent = 0;
+        double parsed_nm             = 0;
+        double reradiation_nm        = 0;
+
+        for (int s = 0; s < 4; s++) {
+            const SpectrumType type = EXRChannelName::parse(
+              EXRChannelName::emissive(s, wavelength_nm),
+              polarisationComponent,
+              parsed_nm,
+              reradiation_nm);
+
+            CHECK(isEmissiveSpectrum(type));
+            CHECK(polarisationComponent == s);
+            CHECK(parsed_nm == wavelength_nm);
+        }
+
+        CHECK(
+          EXRChannelName::parse(
+            EXRChannelName::reflective(wavelength_nm),
+            polarisationComponent,
+            parsed_nm,
+            reradiation_nm)
+          == SpectrumType::REFLECTIVE);
+        CHECK(parsed_nm == wavelength_nm);
+
+        CHECK(
+          EXRChannelName::parse(
+            EXRChannelName::reradiation(wavelength_nm, reemission_nm),
+            polarisationComponent,
+            parsed_nm,
+            reradiation_nm)
+          == SpectrumType::BISPECTRAL);
+        CHECK(parsed_nm == wavelength_nm);
+        CHECK(reradiation_nm == reemission_nm);
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    testParse();
+    testFormat();
+    testRoundTrip();
+
+    return nFailures == 0 ? 0 : 1;
+}
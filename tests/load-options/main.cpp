@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Loads a subset of the components and of the bands of images holding
+// channel sensitivities
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <EXRBiSpectralImage.h>
+#include <EXRSpectralImage.h>
+
+using namespace SEXR;
+
+int nFailures = 0;
+
+#define CHECK(condition)                                         \
+    do {                                                         \
+        if (!(condition)) {                                      \
+            std::fprintf(                                        \
+              stderr,                                            \
+              "%s:%d: %s\n",                                     \
+              __FILE__,                                          \
+              __LINE__,                                          \
+              #condition);                                       \
+            nFailures++;                                         \
+        }                                                        \
+    } while (0)
+
+
+template<typename Image>
+void testSubset(const std::string &filename, SpectrumType type)
+{
+    const std::vector<float> wavelengths_nm = {400, 450, 500, 550, 600};
+
+    Image image(4, 3, wavelengths_nm, type);
+
+    for (size_t wl_idx = 0; wl_idx < wavelengths_nm.size(); wl_idx++) {
+        image.setChannelSensitivity(
+          wl_idx,
+          {wavelengths_nm[wl_idx], wavelengths_nm[wl_idx] + 10},
+          {float(wl_idx), 1.F});
+    }
+
+    image.save(filename);
+
+    LoadOptions options;
+    options.setComponents(REFLECTIVE);
+    options.setWavelengths({450, 550});
+
+    const Image loaded(filename, options);
+
+    CHECK(loaded.isReflective() && !loaded.isEmissive());
+    CHECK(loaded.nSpectralBands() == 2);
+    CHECK(loaded.channelSensitivities().size() == 2);
+
+    // The sensitivities follow their bands
+    CHECK(loaded.channelSensitivity(0).size() == 2);
+    CHECK(loaded.channelSensitivity(0).value(0) == 1.F);
+    CHECK(loaded.channelSensitivity(1).size() == 2);
+    CHECK(loaded.channelSensitivity(1).value(0) == 3.F);
+}
+
+
+int main()
+{
+    testSubset<EXRSpectralImage>(
+      "load-options-spectral.exr",
+      EMISSIVE | REFLECTIVE);
+    testSubset<EXRBiSpectralImage>(
+      "load-options-bispectral.exr",
+      EMISSIVE | BISPECTRAL);
+
+    return nFailures == 0 ? 0 : 1;
+}
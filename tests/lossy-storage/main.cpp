@@ -0,0 +1,246 @@
+/**
+ * Copyright (c) 2020 - 2021
+ * Alban Fichet, Romain Pacanowski, Alexander Wilkie
+ * Institut d'Optique Graduate School, CNRS - Universite de Bordeaux,
+ * Inria, Charles University
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *  * Neither the name of Institut d'Optique Graduate School, CNRS -
+ * Universite de Bordeaux, Inria, Charles University nor the names of
+ * its contributors may be used to endorse or promote products derived
+ * from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Saves images with HALF and quantised UINT channels, and checks the
+// values loaded back stay within the error bounds of the storage
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <OpenEXR/ImfFloatVectorAttribute.h>
+#include <OpenEXR/ImfInputFile.h>
+
+#include <EXRBiSpectralImage.h>
+#include <EXRSpectralImage.h>
+
+using namespace SEXR;
+
+int nFailures = 0;
+
+#define CHECK(condition)                                         \
+    do {                                                         \
+        if (!(condition)) {                                      \
+            std::fprintf(                                        \
+              stderr,                                            \
+              "%s:%d: %s\n",                                     \
+              __FILE__,                                          \
+              __LINE__,                                          \
+              #condition);                                       \
+            nFailures++;                                         \
+        }                                                        \
+    } while (0)
+
+
+const std::vector<float> WAVELENGTHS_NM = {400, 450, 500, 550, 600};
+const size_t             WIDTH          = 7;
+const size_t             HEIGHT         = 5;
+
+
+// Gets a float vector attribute of a file, empty when missing
+std::vector<float>
+readAttribute(const std::string &filename, const char *name)
+{
+    Imf::InputFile file(filename.c_str());
+
+    const Imf::FloatVectorAttribute *attr
+      = file.header().findTypedAttribute<Imf::FloatVectorAttribute>(name);
+
+    return attr != nullptr ? attr->value() : std::vector<float>();
+}
+
+
+void testQuantisedReflective()
+{
+    const std::string filename = "lossy-storage-uint.exr";
+
+    EXRBiSpectralImage image(WIDTH, HEIGHT, WAVELENGTHS_NM, BISPECTRAL);
+
+    for (size_t y = 0; y < HEIGHT; y++) {
+        for (size_t x = 0; x < WIDTH; x++) {
+            for (size_t i = 0; i < image.nSpectralBands(); i++) {
+                image.reflective(x, y, i, i) = std::sin(float(x + y + i));
+
+                for (size_t j = i + 1; j < image.nSpectralBands(); j++) {
+                    image.reflective(x, y, i, j)
+                      = 0.01F * float(x * y + i) / float(j);
+                }
+            }
+        }
+    }
+
+    SaveOptions options;
+    options.setPixelTypes(Imf::FLOAT, Imf::UINT, Imf::UINT);
+
+    image.save(filename, options);
+
+    // The quantisation is stored as scale, offset
+    const std::vector<float> reflectiveQuantisation = readAttribute(
+      filename,
+      EXRBiSpectralImage::REFLECTIVE_QUANTISATION_ATTR);
+    const std::vector<float> reradiationQuantisation = readAttribute(
+      filename,
+      EXRBiSpectralImage::RERADIATION_QUANTISATION_ATTR);
+
+    CHECK(reflectiveQuantisation.size() == 2);
+    CHECK(reradiationQuantisation.size() == 2);
+
+    if (
+      reflectiveQuantisation.size() != 2
+      || reradiationQuantisation.size() != 2) {
+        return;
+    }
+
+    // Half a quantisation step, plus the rounding of the conversion
+    const float reflectiveError  = 0.5F * reflectiveQuantisation[0] + 1e-6F;
+    const float reradiationError = 0.5F * reradiationQuantisation[0] + 1e-6F;
+
+    const EXRBiSpectralImage loaded(filename);
+
+    CHECK(loaded.isBispectral());
+
+    for (size_t y = 0; y < HEIGHT; y++) {
+        for (size_t x = 0; x < WIDTH; x++) {
+            for (size_t i = 0; i < image.nSpectralBands(); i++) {
+                const float diagonal = image.reflective(x, y, i, i);
+
+                CHECK(
+                  std::abs(loaded.reflective(x, y, i, i) - diagonal)
+                  <= reflectiveError);
+
+                for (size_t j = i + 1; j < image.nSpectralBands(); j++) {
+                    CHECK(
+                      std::abs(
+                        loaded.reflective(x, y, i, j)
+                        - image.reflective(x, y, i, j))
+                      <= reradiationError);
+                }
+            }
+        }
+    }
+}
+
+
+void testScaledHalfEmissive()
+{
+    const std::string filename = "lossy-storage-half.exr";
+
+    EXRSpectralImage image(WIDTH, HEIGHT, WAVELENGTHS_NM, EMISSIVE);
+
+    // Bands far above the HALF range, in range, and below its normal
+    // values
+    const float bandScales[] = {1e6F, 1e5F, 1.F, 1e-3F, 1e-6F};
+
+    for (size_t y = 0; y < HEIGHT; y++) {
+        for (size_t x = 0; x < WIDTH; x++) {
+            for (size_t i = 0; i < image.nSpectralBands(); i++) {
+                image.emissive(x, y, i, 0)
+                  = bandScales[i] * float(1 + x + 2 * y);
+            }
+        }
+    }
+
+    SaveOptions options;
+    options.setPixelTypes(Imf::HALF, Imf::FLOAT, Imf::FLOAT);
+    options.setEmissiveScaling(true);
+
+    image.save(filename, options);
+
+    const std::vector<float> scales
+      = readAttribute(filename, EXRSpectralImage::EMISSIVE_SCALE_ATTR);
+
+    CHECK(scales.size() == image.nSpectralBands());
+
+    if (scales.size() != image.nSpectralBands()) {
+        return;
+    }
+
+    // Each scale is a power of two, exactly applied back on load
+    for (float scale : scales) {
+        int exponent;
+        CHECK(std::frexp(scale, &exponent) == 0.5F);
+    }
+
+    const EXRSpectralImage loaded(filename);
+
+    for (size_t y = 0; y < HEIGHT; y++) {
+        for (size_t x = 0; x < WIDTH; x++) {
+            for (size_t i = 0; i < image.nSpectralBands(); i++) {
+                const float value = image.emissive(x, y, i, 0);
+
+                // The stored value fits in HALF
+                CHECK(std::abs(value / scales[i]) <= 65504.F);
+
+                // HALF keeps 11 significant bits
+                CHECK(std::isfinite(loaded.emissive(x, y, i, 0)));
+                CHECK(
+                  std::abs(loaded.emissive(x, y, i, 0) - value)
+                  <= std::ldexp(std::abs(value), -11));
+            }
+        }
+    }
+}
+
+
+void testQuantisedEmissive()
+{
+    EXRSpectralImage image(WIDTH, HEIGHT, WAVELENGTHS_NM, EMISSIVE);
+
+    SaveOptions options;
+    options.setPixelTypes(Imf::UINT, Imf::FLOAT, Imf::FLOAT);
+
+    // Emissive values are not bounded
+    bool rejected = false;
+
+    try {
+        image.save("lossy-storage-invalid.exr", options);
+    } catch (SpectralImage::Errors error) {
+        rejected = error == SpectralImage::INVALID_OPTIONS;
+    }
+
+    CHECK(rejected);
+}
+
+
+int main()
+{
+    testQuantisedReflective();
+    testScaledHalfEmissive();
+    testQuantisedEmissive();
+
+    return nFailures == 0 ? 0 : 1;
+}